@@ -0,0 +1,197 @@
+#ifndef ADAPTIVE_STEPPER_HEADER_GUARD
+#define ADAPTIVE_STEPPER_HEADER_GUARD
+
+#include <KeepMeAlive.h>
+#include "Mesh.h"
+
+/*
+    Advances a mesh through one cycle with a time step adjusted to the local truncation error.
+
+    The error is estimated by step doubling: every step is taken once with the full step and
+    once as two half steps, and the largest difference between the temperatures (the condensed
+    mid-side ones included) is the estimate. The half step result is kept. The step is halved
+    when the estimate exceeds the tolerance, and doubled when it falls below a quarter of it
+    (the local error of implicit Euler is quadratic in the step).
+
+    The steps are always backward Euler ones, the extrapolation makes them second order anyway.
+    The step only changes by factors of 2, so the two systems needed are always just swapped
+    or one of them reassembled - the full step system is the `system` of the mesh, the half
+    step one is stored here. The last step is shortened to end exactly at `tauEnd`.
+    The cycle also ends once the temperatures change slower than `steadyRate`.
+*/
+template<int nNodes, typename T, int order = 1>
+class AdaptiveStepper {
+public:
+    using MeshT = Mesh<nNodes, T, order>;
+    static constexpr int nTemperatures = MeshT::nTemperatures;
+
+    // the step may get at most 2^maxLevel times shorter or longer than the initial one
+    static constexpr int maxLevel = 6;
+
+private:
+    MeshT& mesh;
+    typename MeshT::System half;
+
+    T saved[nTemperatures];
+    T full[nTemperatures];
+
+    const Input* input = nullptr;
+    float initialStep = 0;
+    float dTau = 0;
+    float tauEnd = 0;
+    float rMax = 0;
+    float tolerance = 0;
+    float steadyRate = 0;
+
+    float tau = 0;
+    int level = 0;
+    bool done = false;
+    unsigned nRejected = 0;
+
+    void save(T* dst) const {
+        for (int i = 0; i < nTemperatures; i++)
+            dst[i] = mesh.temperature(i);
+    }
+
+    void restore(const T* src) {
+        for (int i = 0; i < nTemperatures; i++)
+            mesh.temperature(i) = src[i];
+    }
+
+    // largest difference between the current node temperatures and `other`
+    float maxDifference(const T* other) const {
+        float diff = 0;
+
+        for (int i = 0; i < nTemperatures; i++) {
+            float d = fabs((float) (mesh.temperature(i) - other[i]));
+
+            if (d > diff)
+                diff = d;
+        }
+
+        return diff;
+    }
+
+    void assembleBoth() {
+        mesh.assemble(mesh.system, dTau, rMax, *input);
+        mesh.assemble(half, dTau/2, rMax, *input);
+    }
+
+    void shrink() {
+        level--;
+        dTau /= 2;
+        mesh.system = half;
+        mesh.assemble(half, dTau/2, rMax, *input);
+    }
+
+    void grow() {
+        level++;
+        dTau *= 2;
+        half = mesh.system;
+        mesh.assemble(mesh.system, dTau, rMax, *input);
+    }
+
+public:
+    explicit AdaptiveStepper(MeshT& mesh): mesh(mesh) {}
+
+    /*
+        Sets up a cycle of length `tauEnd`, starting with the step `initialStep`. `tolerance`
+        is the allowed local error of one step [deg C] and `steadyRate` the rate of change of
+        the temperatures [deg C/s] below which the cycle ends early (0 disables it).
+    */
+    void start(
+        float initialStep,
+        float tauEnd,
+        float rMax,
+        float tolerance,
+        float steadyRate,
+        const Input& input
+    ) {
+        this->initialStep = initialStep;
+        this->tauEnd = tauEnd;
+        this->rMax = rMax;
+        this->tolerance = tolerance;
+        this->steadyRate = steadyRate;
+        this->input = &input;
+
+        mesh.selectTimeScheme(TimeScheme::BackwardEuler);
+        restart();
+    }
+
+    // Starts the cycle again from the current node temperatures
+    void restart() {
+        tau = 0;
+        level = 0;
+        done = false;
+        nRejected = 0;
+        dTau = initialStep;
+
+        assembleBoth();
+    }
+
+    // Takes one accepted step
+    void step(float tAmbient) {
+        if (done)
+            return;
+
+        save(saved);
+
+        if (tau + dTau >= tauEnd) {
+            // the last step - the systems get reassembled when the cycle is restarted anyway
+            float last = tauEnd - tau;
+            mesh.assemble(mesh.system, last, rMax, *input);
+            mesh.integrateStep(mesh.system, tAmbient);
+
+            tau = tauEnd;
+            done = true;
+            return;
+        }
+
+        float error;
+
+        while (true) {
+            mesh.integrateStep(mesh.system, tAmbient);
+            save(full);
+            restore(saved);
+
+            mesh.integrateStep(half, tAmbient);
+            mesh.integrateStep(half, tAmbient);
+
+            error = maxDifference(full);
+            watchdogTimer.reset();
+
+            if (error <= tolerance || level == -maxLevel)
+                break;
+
+            restore(saved);
+            shrink();
+            nRejected++;
+        }
+
+        // local extrapolation: the error of the half step result is about the difference
+        // between the two, so subtracting it gives a second order accurate result
+        for (int i = 0; i < nTemperatures; i++) {
+            T& t = mesh.temperature(i);
+            t = t + (t - full[i]);
+        }
+
+        tau += dTau;
+
+        if (steadyRate > 0 && maxDifference(saved) < steadyRate * dTau)
+            done = true;
+
+        if (error < tolerance/4 && level < maxLevel)
+            grow();
+    }
+
+    bool finished() const { return done; }
+
+    // simulated time since the start of the cycle
+    float time() const { return tau; }
+
+    float stepSize() const { return dTau; }
+
+    unsigned rejectedSteps() const { return nRejected; }
+};
+
+#endif
@@ -15,6 +15,13 @@ using namespace lcdut;
 
 /*
     Responsible for buffering the output to the LCD.
+
+    Each I2C write takes hundreds of microseconds, so `flush` sends only the characters that
+    differ from what the LCD shows (kept in `shown`), in runs. A cursor move is one command, as
+    long as a character, so changes up to `maxGap` characters apart are sent as one run, and
+    the cursor is moved only when the next run does not start where the LCD cursor already is.
+    For the same reason `setCursor` just sets the position of the next write, and moves the LCD
+    cursor only while it is visible.
 */
 template<uint8_t nColsT, uint8_t nRowsT>
 class BufferedLcd : public LiquidCrystal_I2C {
@@ -22,46 +29,78 @@ public:
     static constexpr uint8_t size = nRowsT * nColsT;
 
 private:
+    static constexpr uint8_t maxGap = 1;
+    static constexpr uint8_t unknown = 0xFF;
+
     char screenBuffer[size];
+    // contents of the LCD, valid unless `redraw` is set
+    char shown[size];
+    bool redraw = true;
+
     uint8_t row = 0;
     uint8_t col = 0;
 
+    // position of the LCD cursor, if known
+    uint8_t lcdRow = unknown;
+    uint8_t lcdCol = unknown;
+    bool cursorVisible = false;
+
     using super = LiquidCrystal_I2C;
 
-    size_t writeToScreen(const uint8_t* buffer, size_t size) {
-        DBG_Serial("Screen write called" << endl);
-        size_t n = 0;
+    bool changed(uint8_t i) const {
+        return redraw || screenBuffer[i] != shown[i];
+    }
 
-        while (size--) {
-            if (super::write(*buffer++))
-                n++;
-            else
-                break;
+    void moveCursor(uint8_t col, uint8_t row) {
+        if (col == lcdCol && row == lcdRow)
+            return;
+
+        super::setCursor(col, row);
+        lcdCol = col;
+        lcdRow = row;
+    }
+
+    // Sends the characters from `from` up to `to` (exclusive) of the row
+    void writeRun(uint8_t row, uint8_t from, uint8_t to) {
+        moveCursor(from, row);
+
+        for (uint8_t i = row*nColsT + from; i < row*nColsT + to; i++) {
+            super::write(screenBuffer[i]);
+            shown[i] = screenBuffer[i];
         }
 
-        return n;
+        DBG_Serial("line " << row << ": columns " << from << " to " << to - 1 << endl);
+
+        // the LCD moves its cursor after every character
+        lcdCol = to;
     }
 
     void flushNoCursorReset() {
         DBG_Serial(DBG_HEADER() << "Flushing the screen buffer:" << endl);
 
-        for (uint8_t i = 0; i < nRowsT; i++) {
-            super::setCursor(0, i);
+        for (uint8_t r = 0; r < nRowsT; r++) {
+            uint8_t c = 0;
 
-            auto start = screenBuffer + i*nColsT;
+            while (c < nColsT) {
+                if (!changed(r*nColsT + c)) {
+                    c++;
+                    continue;
+                }
 
-            writeToScreen((const uint8_t *)start, nColsT);
+                uint8_t from = c;
+                uint8_t to = c + 1;
 
-            DBG_Serial("line " << i << " (string): " << start << endl);
-            DBG_Serial("line " << i << " (ints):   ");
+                for (c = to; c < nColsT && c - to <= maxGap; c++) {
+                    if (changed(r*nColsT + c))
+                        to = c + 1;
+                }
 
-            #if DEBUG_PRINTS
-            for (auto j = start; j < start + nColsT; j++)
-                DBG_Serial((uint8_t) *start << ' ');
-            #endif
-
-            DBG_Serial(endl);
+                writeRun(r, from, to);
+                c = to;
+            }
         }
+
+        redraw = false;
     }
 
 public:
@@ -73,6 +112,12 @@ public:
         memset(screenBuffer, ' ', size);
     }
 
+    // Makes the next flush send the whole buffer, e.g. when the LCD was cleared or reset
+    void invalidate() {
+        redraw = true;
+        lcdRow = lcdCol = unknown;
+    }
+
     static constexpr uint8_t cols = nColsT;
     static constexpr uint8_t rows = nRowsT;
 
@@ -87,14 +132,29 @@ public:
 
     void flush() {
         flushNoCursorReset();
-        super::setCursor(col, row);
+
+        if (cursorVisible)
+            moveCursor(col, row);
     }
 
     virtual void setCursor(uint8_t col, uint8_t row) {
         DBG_Serial(DBG_HEADER() << "Cursor set to " << col << ", " << row << endl);
         this->row = row;
         this->col = col;
-        super::setCursor(col, row);
+
+        if (cursorVisible)
+            moveCursor(col, row);
+    }
+
+    void cursor_on() {
+        cursorVisible = true;
+        super::cursor_on();
+        moveCursor(col, row);
+    }
+
+    void cursor_off() {
+        cursorVisible = false;
+        super::cursor_off();
     }
 
     virtual size_t write(uint8_t val) {
@@ -112,8 +172,11 @@ public:
             screenBuffer[row*nColsT + col] = val;
             col++;
         } else {
+            // outside of the screen, straight to the LCD
             flushNoCursorReset();
+            moveCursor(col, row);
             super::write(val);
+            lcdRow = lcdCol = unknown;
         }
 
         return 1;
@@ -4,78 +4,323 @@
 #include "Mesh.h"
 
 /*
-    This file contains all packet definitions that are used in the binary communication protocol
-    between the Arduino and the temperature simulating script. It is mirrored on the python side
-    by the `communication.py` file
+    This file contains the binary telemetry protocol between the Arduino and the temperature
+    simulating script. It is mirrored on the python side by the `communication.py` file.
 
-    TODO: add synchronization bytes so the communication does not error out when falls out of sync
+    Everything is sent in frames:
+
+        0xA5 0x5A | type (1 B) | payload length (1 B) | payload | CRC (2 B)
+
+    The CRC is CRC-16/CCITT-FALSE of the type, length and payload, and all the numbers are little
+    endian. A reader that lost or misread some bytes skips to the next sync marker followed by a
+    frame with a valid CRC, so it gets back in step after at most one lost frame.
+
+    Frame types:
+        MeshInfo - sent at the start of every cycle. The node count, the number of steps and
+            duration of the cycle, the counts of dropped frames and coalesced steps so far, and
+            the node radii, which do not change within a cycle, so the iteration frames do not
+            repeat them.
+        Iterations - a batch of steps: the numbers of the first and last one, flags, the number
+            of steps and of nodes, then for every step the time after it [s], how long it took
+            [us] and the node temperatures, quantized to int16 in 1/temperatureScale deg C. The
+            steps are consecutive, except for the last one, which may come later (see Telemetry).
+            The last batch of a cycle is sent at its end, possibly empty, with the CycleEnd flag.
 */
 
-enum class PacketType : unsigned int {
-    InvalidPacket,
-    IterationData,
-    BenchmarkData
-};
+namespace telemetry {
+    constexpr uint8_t syncFirst = 0xA5;
+    constexpr uint8_t syncSecond = 0x5A;
 
-struct Packet {
-    const PacketType type;
-    // lenght does not include the packet header
-    const size_t length;
+    // temperatures are sent in 1/16 deg C, which covers -2048 to 2047 deg C
+    constexpr uint8_t temperatureShift = 4;
+    constexpr int16_t temperatureScale = 1 << temperatureShift;
 
-    Packet(PacketType t, size_t len): type(t), length(len) {}
-};
+    enum class FrameType : uint8_t {
+        InvalidFrame,
+        MeshInfo,
+        Iterations
+    };
+
+    enum BatchFlags : uint8_t {
+        CycleEnd = 1
+    };
+
+    inline uint16_t crc16(uint16_t crc, uint8_t data) {
+        crc ^= (uint16_t) data << 8;
+
+        for (uint8_t i = 0; i < 8; i++)
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
 
-template<size_t nNodesT>
-struct IterationDataPacket : public Packet {
-    float tau;
-    int step;
-    unsigned nSteps;
-    const size_t nNodes = nNodesT;
-    const size_t nodeSize = sizeof(typename Mesh<nNodesT>::Node);
-    const typename Mesh<nNodesT>::Node* nodes;
-
-    IterationDataPacket(const typename Mesh<nNodesT>::Node* nodes):
-        Packet(PacketType::IterationData, sizeof(*this) - sizeof(Packet) - sizeof(nodes)),
-        nodes(nodes)
-    {}
-
-    void send() {
-        Serial.write((const byte*)this, sizeof(*this) - sizeof(nodes));
-        Serial.write((const byte*)nodes, nodeSize*nNodes);
+        return crc;
     }
-};
 
-struct BenchmarkDataPacket : public Packet {
-    unsigned long microsStart;
-    unsigned long microsEnd;
+    /*
+        Bytes waiting to be sent. The UART interrupt of the Arduino core sends from its own 64 byte
+        buffer, and `pump` moves into it only as much as it has room for, so nothing here ever
+        waits for the port. The frames are put here whole or not at all.
+    */
+    template<uint16_t capacity>
+    class TxQueue {
+        static_assert(
+            capacity > 0 && capacity <= 256 && (capacity & (capacity - 1)) == 0,
+            "The capacity has to be a power of 2, up to 256"
+        );
+
+        uint8_t data[capacity];
+        // index of the next byte to send
+        uint8_t head = 0;
+        uint16_t count = 0;
+
+    public:
+        uint16_t free() const { return capacity - count; }
+
+        // there has to be room for it, see `free`
+        void push(uint8_t value) {
+            data[(head + count) & (capacity - 1)] = value;
+            count++;
+        }
+
+        void pump() {
+            int room = Serial.availableForWrite();
+
+            while (room-- > 0 && count > 0) {
+                Serial.write(data[head]);
+                head = (head + 1) & (capacity - 1);
+                count--;
+            }
+        }
+    };
+
+    // sync marker, type and length before the payload, CRC after it
+    constexpr uint8_t frameOverhead = 6;
+
+    /*
+        Writes one frame to the queue, field by field, computing its CRC on the way. If the queue
+        has no room for the whole frame, nothing is written and `accepted` is false.
+    */
+    template<class Queue>
+    class FrameWriter {
+        Queue& queue;
+        uint16_t crc = 0xFFFF;
+
+    public:
+        const bool accepted;
+
+        FrameWriter(Queue& queue, FrameType type, uint8_t length):
+            queue(queue),
+            accepted(queue.free() >= length + frameOverhead)
+        {
+            if (!accepted)
+                return;
+
+            queue.push(syncFirst);
+            queue.push(syncSecond);
+            put((uint8_t) type);
+            put(length);
+        }
+
+        void put(uint8_t data) {
+            if (!accepted)
+                return;
+
+            crc = crc16(crc, data);
+            queue.push(data);
+        }
+
+        template<typename V>
+        void put(const V& value) {
+            const uint8_t* bytes = (const uint8_t*) &value;
+
+            for (uint8_t i = 0; i < sizeof(V); i++)
+                put(bytes[i]);
+        }
+
+        void end() {
+            if (!accepted)
+                return;
+
+            queue.push((uint8_t) crc);
+            queue.push((uint8_t) (crc >> 8));
+        }
+    };
+
+    inline int16_t saturate(long value) {
+        return value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value;
+    }
+
+    inline int16_t quantize(float t) {
+        return saturate(lround(t * temperatureScale));
+    }
+
+    // straight from the fixed point value, without going through float
+    template<int fracBits>
+    inline int16_t quantize(Fixed<fracBits> t) {
+        constexpr int shift = fracBits - temperatureShift;
+        return saturate((t.raw() + (int32_t(1) << (shift - 1))) >> shift);
+    }
+} // namespace telemetry
+
+/*
+    Collects the steps of a cycle and sends them in batches of `batchSize`, as Iterations
+    frames. The steps are kept quantized, so a batch takes 6 + 2*nNodes bytes per step.
+
+    The frames go through a queue of `queueSize` bytes, so recording a step never waits for the
+    serial port. When the queue has no room for a batch, with `coalesce` the batch is kept and
+    every next step replaces its last one until the queue has room - the PC gets the latest
+    temperatures, with a gap in the steps. Without it the batch is dropped. The MeshInfo frame
+    and the last batch of a cycle are dropped when they do not fit either way. The number of
+    dropped frames and replaced steps is sent in the MeshInfo frame.
+*/
+template<int nNodes, typename T, uint8_t batchSize, uint16_t queueSize, bool coalesce>
+class Telemetry {
+    struct Iteration {
+        float tau;
+        uint16_t duration;
+        int16_t t[nNodes];
+    };
+
+    static constexpr int batchHeaderSize = 7;
+    static constexpr int iterationSize = sizeof(float) + sizeof(uint16_t) + nNodes*sizeof(int16_t);
+    static constexpr int meshInfoSize = 11 + nNodes*sizeof(float);
+
+    static_assert(batchSize > 0, "The batch has to hold at least one step");
+    static_assert(batchHeaderSize + batchSize*iterationSize <= 255, "The batch does not fit in a frame");
+    static_assert(meshInfoSize <= 255, "The mesh does not fit in a frame");
+    static_assert(
+        batchHeaderSize + batchSize*iterationSize + telemetry::frameOverhead <= queueSize,
+        "The batch does not fit in the queue"
+    );
+
+    telemetry::TxQueue<queueSize> queue;
+
+    Iteration batch[batchSize];
+    uint16_t firstStep = 0;
+    uint16_t lastStep = 0;
+    uint8_t count = 0;
 
-    BenchmarkDataPacket():
-        Packet(PacketType::BenchmarkData, sizeof(*this) - sizeof(Packet)),
-        microsStart(0),
-        microsEnd(0)
-    {}
+    uint16_t nDropped = 0;
+    uint16_t nCoalesced = 0;
 
-    BenchmarkDataPacket& start() {
-        microsStart = micros();
-        return *this;
+    // Puts the batch in the queue, returns false if there was no room for it
+    bool send(uint8_t flags) {
+        telemetry::FrameWriter<decltype(queue)> frame{
+            queue,
+            telemetry::FrameType::Iterations,
+            (uint8_t) (batchHeaderSize + count*iterationSize)
+        };
+
+        if (!frame.accepted)
+            return false;
+
+        frame.put(firstStep);
+        frame.put(lastStep);
+        frame.put(flags);
+        frame.put(count);
+        frame.put((uint8_t) nNodes);
+
+        for (uint8_t k = 0; k < count; k++) {
+            frame.put(batch[k].tau);
+            frame.put(batch[k].duration);
+
+            for (int i = 0; i < nNodes; i++)
+                frame.put(batch[k].t[i]);
+        }
+
+        frame.end();
+        queue.pump();
+        count = 0;
+        return true;
     }
 
-    BenchmarkDataPacket& end() {
-        microsEnd = micros();
-        return *this;
+    void sendBatch(uint8_t flags) {
+        if (send(flags))
+            return;
+
+        if (!coalesce || (flags & telemetry::CycleEnd)) {
+            nDropped++;
+            count = 0;
+        }
     }
 
-    BenchmarkDataPacket& send() {
-        // send whole packet, with header!
-        Serial.write((const byte*)this, sizeof(*this));
-        return *this;
+public:
+    // Sends the cycle parameters and drops the steps not sent yet, which belong to the old ones
+    void start(const MeshNode<T>* nodes, unsigned nSteps, float tauEnd) {
+        count = 0;
+        queue.pump();
+
+        telemetry::FrameWriter<decltype(queue)> frame{
+            queue,
+            telemetry::FrameType::MeshInfo,
+            (uint8_t) meshInfoSize
+        };
+
+        if (!frame.accepted) {
+            nDropped++;
+            return;
+        }
+
+        frame.put((uint8_t) nNodes);
+        frame.put((uint16_t) nSteps);
+        frame.put(tauEnd);
+        frame.put(nDropped);
+        frame.put(nCoalesced);
+
+        for (int i = 0; i < nNodes; i++)
+            frame.put(nodes[i].r);
+
+        frame.end();
+        queue.pump();
     }
 
-    BenchmarkDataPacket& clear() {
-        microsStart = 0;
-        microsEnd = 0;
-        return *this;
+    /*
+        Stores the node temperatures after step number `step`, which took `duration` [us], and
+        sends the batch once it is full
+    */
+    void record(uint16_t step, float tau, unsigned long duration, const MeshNode<T>* nodes) {
+        queue.pump();
+
+        // a batch kept back by coalescing
+        if (count == batchSize)
+            sendBatch(0);
+
+        Iteration* it;
+
+        if (count == batchSize) {
+            it = &batch[count - 1];
+            nCoalesced++;
+        }
+        else {
+            if (count == 0)
+                firstStep = step;
+
+            it = &batch[count++];
+        }
+
+        lastStep = step;
+        it->tau = tau;
+        it->duration = duration > UINT16_MAX ? UINT16_MAX : duration;
+
+        for (int i = 0; i < nNodes; i++)
+            it->t[i] = telemetry::quantize(nodes[i].t);
+
+        if (count == batchSize)
+            sendBatch(0);
+    }
+
+    // Sends the steps collected so far, if any, or an empty batch, as the end of the cycle
+    void endCycle() {
+        sendBatch(telemetry::CycleEnd);
     }
+
+    // Moves what it can from the queue to the serial port, without waiting
+    void pump() {
+        queue.pump();
+    }
+
+    // frames that did not fit in the queue
+    uint16_t droppedFrames() const { return nDropped; }
+    // steps replaced by later ones, while a batch waited for room in the queue
+    uint16_t coalescedSteps() const { return nCoalesced; }
 };
 
 #endif
@@ -15,7 +15,7 @@
 
 // EEPROM
 #define EEPROM_INPUT_PARAMS_ADDR 0
-#define EEPROM_READ_INDICATOR_VAL 21
+#define EEPROM_READ_INDICATOR_VAL 24
 
 // LCD
 #define LCD_I2C_ADDR 0x3F
@@ -27,13 +27,79 @@
 #define TEMP_CS_PIN 3
 #define TEMP_CLK_PIN 2
 
+// furnace temperature sampling (see TemperatureSampler.h): the period [ms], up to 1000 - a
+// conversion of the MAX31855 takes up to 100 ms, the number of the samples kept for the
+// interpolation, and the weight of a new sample in the smoothing filter (1 - no smoothing)
+#define TEMP_SAMPLE_PERIOD 100
+#define TEMP_HISTORY_SIZE 8
+#define TEMP_FILTER_ALPHA 0.5f
+
 // serial communication
 #define DEBUG_SERIAL_TEMP false
 #define TELEMETRY false
+// number of steps sent in one telemetry frame (see communication.h)
+#define TELEMETRY_BATCH 4
+// size of the telemetry send queue [B], a power of 2 up to 256. When it is full, the steps are
+// coalesced (only the latest one is kept until there is room) or, with false, dropped
+#define TELEMETRY_QUEUE_SIZE 128
+#define TELEMETRY_COALESCE true
 
 // number of mesh elements
 #define MESH_SIZE 10
 
+// order of the mesh elements: 1 - linear, 2 - quadratic, with the mid-side nodes condensed out
+// of the system (about as accurate as twice as many linear elements, see Mesh.h)
+#define ELEMENT_ORDER 1
+
+// assemble and factorize the system matrix once per cycle, instead of in every step
+#define CACHED_SYSTEM_MATRIX true
+
+// number type of the node temperatures: float, or Q16_16 for the fixed point solver (results
+// within 0.05 deg C of float; a product takes 86 cycles in the multiply kernel of Fixed.h, plus
+// its sign correction and shift - the whole step is for the avrsim profile to time)
+#define MESH_VALUE_TYPE float
+
+// adjust the time step to the local error estimate (tolerance set in the menu), instead of
+// taking a fixed number of steps per cycle
+#define ADAPTIVE_TIME_STEP false
+
+// heat capacity and conductivity depending on the temperature, from the tables in
+// MaterialTables.h (the menu values are not used then). Each step is iterated to the tolerance
+// set in the menu. Needs a fixed time step and linear elements
+#define TEMPERATURE_DEPENDENT_MATERIAL false
+
+#if TEMPERATURE_DEPENDENT_MATERIAL && (ADAPTIVE_TIME_STEP || ELEMENT_ORDER != 1)
+#error "Temperature-dependent material needs a fixed time step and linear elements"
+#endif
+
+// advance the temperatures exactly, in the eigenmodes of the system (see ModalSolver.h),
+// instead of solving it in every step. A step of any length costs the same, so one step per
+// cycle gives the end temperatures, several follow the changes of the furnace temperature.
+// MODAL_MODES of them are kept, the faster ones are taken as decayed within one step. Needs a
+// fixed time step, constant material and linear elements
+#define MODAL_SOLVER false
+#define MODAL_MODES (MESH_SIZE + 1)
+
+#if MODAL_SOLVER && (ADAPTIVE_TIME_STEP || TEMPERATURE_DEPENDENT_MATERIAL || ELEMENT_ORDER != 1)
+#error "The modal solver needs a fixed time step, constant material and linear elements"
+#endif
+
+// run the steps by the wall clock, so that a cycle takes as long as the wire spends in the
+// furnace. When the steps do not keep up, the cycles get cheaper: first the steps are left out
+// of the telemetry, then the time scheme and integration rule get simpler, then the number of
+// steps is halved (or the tolerance of the adaptive step doubled) - see RealTime.h
+#define REAL_TIME false
+
+// take the end temperatures of the cycles from the table generated on the PC (see Surrogate.h)
+// instead of simulating them, for a constant furnace temperature. The cycles out of the table,
+// or with other parameters than it was made for, are simulated as usual. The looked up cycles
+// send no telemetry. Needs constant material and linear elements
+#define SURROGATE_TABLE false
+
+#if SURROGATE_TABLE && (TEMPERATURE_DEPENDENT_MATERIAL || ELEMENT_ORDER != 1)
+#error "The surrogate table needs constant material and linear elements"
+#endif
+
 // debug
 #define DEBUG_PRINTS false
 
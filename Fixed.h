@@ -0,0 +1,237 @@
+#ifndef FIXED_HEADER_GUARD
+#define FIXED_HEADER_GUARD
+
+#include <stdint.h>
+
+namespace fixed {
+    // Low and high 32 bits of a 64-bit product
+    struct Wide {
+        uint32_t low, high;
+    };
+
+    /*
+        64-bit product of two unsigned 32-bit numbers. avr-gcc would widen both operands of an
+        int64_t product and call the 64x64 bit __muldi3, so on the AVR it is summed here from
+        the 16 products of the bytes, column by column of the result: 86 cycles.
+    */
+    inline Wide multiplyUnsigned(uint32_t a, uint32_t b) {
+    #if defined(__AVR__)
+        Wide p;
+        uint8_t zero;
+
+        // the bytes of column k go to result byte k, with the carries in the next two
+        __asm__ (
+            "clr %[z]                   \n\t"
+            "mul %A[a], %A[b]           \n\t"
+            "mov %A[lo], r0             \n\t"
+            "mov %B[lo], r1             \n\t"
+            "clr %C[lo]                 \n\t"
+            "clr %D[lo]                 \n\t"
+            "mul %A[a], %B[b]           \n\t"
+            "add %B[lo], r0             \n\t"
+            "adc %C[lo], r1             \n\t"
+            "adc %D[lo], %[z]           \n\t"
+            "mul %B[a], %A[b]           \n\t"
+            "add %B[lo], r0             \n\t"
+            "adc %C[lo], r1             \n\t"
+            "adc %D[lo], %[z]           \n\t"
+            "clr %A[hi]                 \n\t"
+            "mul %A[a], %C[b]           \n\t"
+            "add %C[lo], r0             \n\t"
+            "adc %D[lo], r1             \n\t"
+            "adc %A[hi], %[z]           \n\t"
+            "mul %B[a], %B[b]           \n\t"
+            "add %C[lo], r0             \n\t"
+            "adc %D[lo], r1             \n\t"
+            "adc %A[hi], %[z]           \n\t"
+            "mul %C[a], %A[b]           \n\t"
+            "add %C[lo], r0             \n\t"
+            "adc %D[lo], r1             \n\t"
+            "adc %A[hi], %[z]           \n\t"
+            "clr %B[hi]                 \n\t"
+            "mul %A[a], %D[b]           \n\t"
+            "add %D[lo], r0             \n\t"
+            "adc %A[hi], r1             \n\t"
+            "adc %B[hi], %[z]           \n\t"
+            "mul %B[a], %C[b]           \n\t"
+            "add %D[lo], r0             \n\t"
+            "adc %A[hi], r1             \n\t"
+            "adc %B[hi], %[z]           \n\t"
+            "mul %C[a], %B[b]           \n\t"
+            "add %D[lo], r0             \n\t"
+            "adc %A[hi], r1             \n\t"
+            "adc %B[hi], %[z]           \n\t"
+            "mul %D[a], %A[b]           \n\t"
+            "add %D[lo], r0             \n\t"
+            "adc %A[hi], r1             \n\t"
+            "adc %B[hi], %[z]           \n\t"
+            "clr %C[hi]                 \n\t"
+            "mul %B[a], %D[b]           \n\t"
+            "add %A[hi], r0             \n\t"
+            "adc %B[hi], r1             \n\t"
+            "adc %C[hi], %[z]           \n\t"
+            "mul %C[a], %C[b]           \n\t"
+            "add %A[hi], r0             \n\t"
+            "adc %B[hi], r1             \n\t"
+            "adc %C[hi], %[z]           \n\t"
+            "mul %D[a], %B[b]           \n\t"
+            "add %A[hi], r0             \n\t"
+            "adc %B[hi], r1             \n\t"
+            "adc %C[hi], %[z]           \n\t"
+            "clr %D[hi]                 \n\t"
+            "mul %C[a], %D[b]           \n\t"
+            "add %B[hi], r0             \n\t"
+            "adc %C[hi], r1             \n\t"
+            "adc %D[hi], %[z]           \n\t"
+            "mul %D[a], %C[b]           \n\t"
+            "add %B[hi], r0             \n\t"
+            "adc %C[hi], r1             \n\t"
+            "adc %D[hi], %[z]           \n\t"
+            "mul %D[a], %D[b]           \n\t"
+            "add %C[hi], r0             \n\t"
+            "adc %D[hi], r1             \n\t"
+            "clr __zero_reg__           \n\t"
+            : [lo] "=&r" (p.low), [hi] "=&r" (p.high), [z] "=&r" (zero)
+            : [a] "r" (a), [b] "r" (b)
+        );
+
+        return p;
+    #else
+        uint64_t p = uint64_t(a) * b;
+        return { uint32_t(p), uint32_t(p >> 32) };
+    #endif
+    }
+
+    // int32_t((int64_t(a) * b + 2^(shift-1)) >> shift), with the product above
+    template<int shift>
+    inline int32_t multiplyShifted(int32_t a, int32_t b) {
+        Wide p = multiplyUnsigned(a, b);
+
+        // taken as unsigned, a negative factor adds the other one times 2^32
+        if (a < 0)
+            p.high -= uint32_t(b);
+        if (b < 0)
+            p.high -= uint32_t(a);
+
+        uint32_t result = p.high << (32 - shift) | p.low >> shift;
+
+        if (p.low & (uint32_t(1) << (shift - 1)))
+            result++;
+
+        return int32_t(result);
+    }
+
+    /*
+        int32_t(int64_t(a) * 2^shift / b): a 32-bit division, and the remaining `shift` bits of
+        the quotient by shift-and-subtract, instead of the 64-bit division.
+    */
+    template<int shift>
+    inline int32_t divideShifted(int32_t a, int32_t b) {
+        bool negative = (a < 0) != (b < 0);
+        uint32_t n = a < 0 ? -uint32_t(a) : uint32_t(a);
+        uint32_t d = b < 0 ? -uint32_t(b) : uint32_t(b);
+        uint32_t q = n / d;
+        uint32_t r = n % d;
+
+        // r < d <= 2^31, so doubling it does not overflow
+        for (int i = 0; i < shift; i++) {
+            r <<= 1;
+            q <<= 1;
+
+            if (r >= d) {
+                r -= d;
+                q |= 1;
+            }
+        }
+
+        return int32_t(negative ? -q : q);
+    }
+} // namespace fixed
+
+/*
+    Signed fixed point number with `fracBits` fractional bits, stored in 32 bits.
+
+    The ATmega has no FPU, so every float operation is a library call, while adding two fixed
+    point numbers is a plain 32-bit addition. Multiplication forms the 64-bit product (see
+    fixed::multiplyUnsigned) and rounds it back, division divides in 32 bits (see
+    fixed::divideShifted).
+
+    Multiplying numbers of different formats is allowed and the result has the format of the
+    right operand, so `coefficient * value` keeps the format of the value. Conversions from and
+    to float are explicit, so no soft-float operation gets in silently.
+*/
+template<int fracBits>
+class Fixed {
+    static_assert(fracBits > 0 && fracBits < 31, "Unsupported number of fractional bits");
+
+    int32_t value;
+
+    struct RawTag {};
+    constexpr Fixed(int32_t raw, RawTag): value(raw) {}
+
+public:
+    static constexpr int frac = fracBits;
+    static constexpr int32_t one = int32_t(1) << fracBits;
+
+    constexpr Fixed(): value(0) {}
+    explicit constexpr Fixed(int v): value(int32_t(v) * one) {}
+    explicit constexpr Fixed(float v): value(int32_t(v * one + (v < 0 ? -0.5f : 0.5f))) {}
+
+    static constexpr Fixed fromRaw(int32_t raw) {
+        return Fixed(raw, RawTag{});
+    }
+
+    constexpr int32_t raw() const { return value; }
+
+    explicit constexpr operator float() const {
+        return value * (1.f / one);
+    }
+
+    constexpr Fixed operator-() const { return fromRaw(-value); }
+
+    friend constexpr Fixed operator+(Fixed a, Fixed b) { return fromRaw(a.value + b.value); }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) { return fromRaw(a.value - b.value); }
+
+    friend Fixed operator/(Fixed a, Fixed b) {
+        return fromRaw(fixed::divideShifted<fracBits>(a.value, b.value));
+    }
+
+    Fixed& operator+=(Fixed b) { value += b.value; return *this; }
+    Fixed& operator-=(Fixed b) { value -= b.value; return *this; }
+    Fixed& operator*=(Fixed b) { return *this = *this * b; }
+    Fixed& operator/=(Fixed b) { return *this = *this / b; }
+
+    friend constexpr bool operator==(Fixed a, Fixed b) { return a.value == b.value; }
+    friend constexpr bool operator!=(Fixed a, Fixed b) { return a.value != b.value; }
+    friend constexpr bool operator<(Fixed a, Fixed b) { return a.value < b.value; }
+    friend constexpr bool operator>(Fixed a, Fixed b) { return a.value > b.value; }
+    friend constexpr bool operator<=(Fixed a, Fixed b) { return a.value <= b.value; }
+    friend constexpr bool operator>=(Fixed a, Fixed b) { return a.value >= b.value; }
+};
+
+template<int fracA, int fracB>
+Fixed<fracB> operator*(Fixed<fracA> a, Fixed<fracB> b) {
+    return Fixed<fracB>::fromRaw(fixed::multiplyShifted<fracA>(a.raw(), b.raw()));
+}
+
+// temperatures: range of +-32768 with a resolution of 1.5e-5
+using Q16_16 = Fixed<16>;
+// dimensionless coefficients: range of +-128 with a resolution of 6e-8
+using Q8_24 = Fixed<24>;
+
+/*
+    Number type in which a solver with values of type `T` keeps its matrix coefficients.
+    Fixed point values are paired with Q8.24 coefficients - the system is scaled so that they
+    are of the order of 1, where Q8.24 is more precise than Q16.16.
+*/
+template<typename T>
+struct CoefficientType {
+    using type = T;
+};
+
+template<int fracBits>
+struct CoefficientType<Fixed<fracBits>> {
+    using type = Q8_24;
+};
+
+#endif
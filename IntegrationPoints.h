@@ -1,44 +1,145 @@
 #ifndef INTEGRATION_POINTS_H
 #define INTEGRATION_POINTS_H
 
+#include "GaussLegendre.h"
+
+/*
+    Runtime access to the Gauss schemes selectable from the menu (1-4, scheme n uses n+1
+    points). The points are generated by the compiler, see GaussLegendre.h.
+*/
 class IntegrationPoints {
 public:
-    struct Point {
-        float xi, weight;
-    };
+    using Point = gauss::Point<float>;
 
 private:
-    const static inline Point pts[] PROGMEM = {
-        // n == 1
-        { -.577350, 1.       },
-        {  .577350, 1.       },
-
-        // n == 2
-        { -.774597,  .555555 },
-        {  .0     ,  .888888 },
-        {  .774597,  .555555 },
-
-        // n == 3
-        { -.861136,  .347855 },
-        { -.339981,  .652145 },
-        {  .339981,  .652145 },
-        {  .861136,  .347855 },
-
-        // n == 4
-        { -.906180,  .236927 },
-        { -.538469,  .478629 },
-        {  .0     ,  .568889 },
-        {  .538469,  .478629 },
-        {  .906180,  .236927 },
-    };
-
     static inline Point current;
 
 public:
     static inline const Point& get(size_t n, size_t i) {
-        memcpy_P(&current, &pts[static_cast<size_t>(0.5*n*(n + 1) - 1) + i], sizeof(Point));
+        switch (n) {
+            case 1: current = GaussLegendre<2>::point(i); break;
+            case 2: current = GaussLegendre<3>::point(i); break;
+            case 3: current = GaussLegendre<4>::point(i); break;
+            default: current = GaussLegendre<5>::point(i); break;
+        }
+
         return current;
     }
 };
 
+/*
+    Gauss scheme `scheme` (uses scheme+1 points) as compile-time constants of type `T`.
+
+    Over a linear element, the radius is interpolated from the node radii rI and rJ, so every
+    integral the assembly needs is a sum over the points of the form
+        sum_j w_j * r(xi_j) * N_a(xi_j) * N_b(xi_j) = rI * massAB_I + rJ * massAB_J
+    The sums are evaluated here by the compiler, so assembling an element takes a handful of
+    multiply-adds and no loop over the integration points or reads of the point table.
+    They are accumulated in long double and rounded to `T` once.
+*/
+template<unsigned scheme, typename T = float>
+struct GaussScheme {
+    using real = gauss::real;
+    using Rule = GaussLegendre<scheme + 1, real>;
+
+    static constexpr unsigned nPoints = Rule::size;
+
+    // linear shape functions: N_0 = 0.5*(1 - xi), N_1 = 0.5*(1 + xi)
+    static constexpr real shape(unsigned k, unsigned i) {
+        return k == 0 ? 0.5L * (1 - Rule::xi(i)) : 0.5L * (1 + Rule::xi(i));
+    }
+
+    // sum over the points of w * N_k * N_a * N_b
+    static constexpr real moment(unsigned k, unsigned a, unsigned b, unsigned i = 0) {
+        return i == nPoints
+            ? 0
+            : Rule::weight(i) * shape(k, i) * shape(a, i) * shape(b, i) + moment(k, a, b, i + 1);
+    }
+
+    // sum over the points of w * N_k
+    static constexpr real moment(unsigned k, unsigned i = 0) {
+        return i == nPoints ? 0 : Rule::weight(i) * shape(k, i) + moment(k, i + 1);
+    }
+
+    // capacity integrals
+    static constexpr T mass00I = T(moment(0, 0, 0));
+    static constexpr T mass01I = T(moment(0, 0, 1));
+    static constexpr T mass11I = T(moment(0, 1, 1));
+    static constexpr T mass00J = T(moment(1, 0, 0));
+    static constexpr T mass01J = T(moment(1, 0, 1));
+    static constexpr T mass11J = T(moment(1, 1, 1));
+
+    // conductivity integrals
+    static constexpr T stiffI = T(moment(0));
+    static constexpr T stiffJ = T(moment(1));
+
+    /*
+        Quadratic shape functions, of the nodes at xi = -1, 0 and 1:
+        Q_0 = xi*(xi - 1)/2, Q_1 = 1 - xi^2, Q_2 = xi*(xi + 1)/2
+    */
+    static constexpr real quadShape(unsigned a, unsigned i) {
+        return a == 0
+            ? 0.5L * Rule::xi(i) * (Rule::xi(i) - 1)
+            : a == 1 ? 1 - Rule::xi(i) * Rule::xi(i) : 0.5L * Rule::xi(i) * (Rule::xi(i) + 1);
+    }
+
+    // dQ_a/dxi
+    static constexpr real quadSlope(unsigned a, unsigned i) {
+        return a == 0 ? Rule::xi(i) - 0.5L : a == 1 ? -2 * Rule::xi(i) : Rule::xi(i) + 0.5L;
+    }
+
+    // sum over the points of w * N_k * Q_a * Q_b - the radius is still interpolated linearly
+    static constexpr real quadMoment(unsigned k, unsigned a, unsigned b, unsigned i = 0) {
+        return i == nPoints
+            ? 0
+            : Rule::weight(i) * shape(k, i) * quadShape(a, i) * quadShape(b, i) + quadMoment(k, a, b, i + 1);
+    }
+
+    // sum over the points of w * N_k * dQ_a/dxi * dQ_b/dxi
+    static constexpr real quadSlopeMoment(unsigned k, unsigned a, unsigned b, unsigned i = 0) {
+        return i == nPoints
+            ? 0
+            : Rule::weight(i) * shape(k, i) * quadSlope(a, i) * quadSlope(b, i) + quadSlopeMoment(k, a, b, i + 1);
+    }
+};
+
+/*
+    Integrals of the quadratic element, named by its nodes: 0 and 2 are the end ones, 1 is the
+    mid-side one. The `I` ones are multiplied by the radius of node 0, the `J` ones by node 2.
+*/
+template<unsigned scheme, typename T = float>
+struct QuadraticGaussScheme {
+    using S = GaussScheme<scheme>;
+
+    static constexpr unsigned nPoints = S::nPoints;
+
+    // capacity integrals
+    static constexpr T mass00I = T(S::quadMoment(0, 0, 0));
+    static constexpr T mass01I = T(S::quadMoment(0, 0, 1));
+    static constexpr T mass02I = T(S::quadMoment(0, 0, 2));
+    static constexpr T mass11I = T(S::quadMoment(0, 1, 1));
+    static constexpr T mass12I = T(S::quadMoment(0, 1, 2));
+    static constexpr T mass22I = T(S::quadMoment(0, 2, 2));
+    static constexpr T mass00J = T(S::quadMoment(1, 0, 0));
+    static constexpr T mass01J = T(S::quadMoment(1, 0, 1));
+    static constexpr T mass02J = T(S::quadMoment(1, 0, 2));
+    static constexpr T mass11J = T(S::quadMoment(1, 1, 1));
+    static constexpr T mass12J = T(S::quadMoment(1, 1, 2));
+    static constexpr T mass22J = T(S::quadMoment(1, 2, 2));
+
+    // conductivity integrals
+    static constexpr T stiff00I = T(S::quadSlopeMoment(0, 0, 0));
+    static constexpr T stiff01I = T(S::quadSlopeMoment(0, 0, 1));
+    static constexpr T stiff02I = T(S::quadSlopeMoment(0, 0, 2));
+    static constexpr T stiff11I = T(S::quadSlopeMoment(0, 1, 1));
+    static constexpr T stiff12I = T(S::quadSlopeMoment(0, 1, 2));
+    static constexpr T stiff22I = T(S::quadSlopeMoment(0, 2, 2));
+    static constexpr T stiff00J = T(S::quadSlopeMoment(1, 0, 0));
+    static constexpr T stiff01J = T(S::quadSlopeMoment(1, 0, 1));
+    static constexpr T stiff02J = T(S::quadSlopeMoment(1, 0, 2));
+    static constexpr T stiff11J = T(S::quadSlopeMoment(1, 1, 1));
+    static constexpr T stiff12J = T(S::quadSlopeMoment(1, 1, 2));
+    static constexpr T stiff22J = T(S::quadSlopeMoment(1, 2, 2));
+};
+
 #endif
@@ -0,0 +1,85 @@
+#ifndef MATERIAL_TABLES_HEADER_GUARD
+#define MATERIAL_TABLES_HEADER_GUARD
+
+/*
+    Temperature-dependent properties of carbon steel, after EN 1993-1-2, tabulated every 50 deg C
+    from 0 to 1700 deg C and kept in flash. Between the points they are interpolated linearly, so
+    a lookup is one multiplication to find the interval and a read of two table rows - it does
+    not search. Outside of the range the end values are used.
+
+    The latent heat of the ferrite-austenite transformation is included in the heat capacity as
+    the peak around 735 deg C (effective heat capacity). The table holds the averages of the
+    curve over each 50 deg C interval, rather than its values, so the peak is not missed and the
+    enthalpy gained over it is kept. The curves of the standard start at 20 deg C, the first row
+    extends them down to 0 deg C.
+*/
+namespace material {
+    struct Properties {
+        float C;    // [J/(kg*K)]
+        float K;    // [W/(m*K)]
+    };
+
+    constexpr float tMin = 0;       // [deg C]
+    constexpr float tStep = 50;     // [deg C]
+    constexpr uint8_t size = 35;
+
+    const Properties table[size] PROGMEM = {
+        {  434.3f, 54.00f },   // 0 deg C
+        {  459.4f, 52.34f },   // 50 deg C
+        {  487.4f, 50.67f },   // 100 deg C
+        {  510.3f, 49.01f },   // 150 deg C
+        {  529.7f, 47.34f },   // 200 deg C
+        {  547.3f, 45.67f },   // 250 deg C
+        {  564.8f, 44.01f },   // 300 deg C
+        {  583.8f, 42.34f },   // 350 deg C
+        {  606.1f, 40.68f },   // 400 deg C
+        {  633.2f, 39.02f },   // 450 deg C
+        {  666.8f, 37.35f },   // 500 deg C
+        {  708.7f, 35.69f },   // 550 deg C
+        {  758.0f, 34.02f },   // 600 deg C
+        {  817.9f, 32.35f },   // 650 deg C
+        { 1076.4f, 30.69f },   // 700 deg C
+        { 1805.1f, 29.02f },   // 750 deg C
+        {  815.5f, 27.30f },   // 800 deg C
+        {  697.0f, 27.30f },   // 850 deg C
+        {  654.6f, 27.30f },   // 900 deg C
+        {  650.0f, 27.30f },   // 950 deg C
+        {  650.0f, 27.30f },   // 1000 deg C
+        {  650.0f, 27.30f },   // 1050 deg C
+        {  650.0f, 27.30f },   // 1100 deg C
+        {  650.0f, 27.30f },   // 1150 deg C
+        {  650.0f, 27.30f },   // 1200 deg C
+        {  650.0f, 27.30f },   // 1250 deg C
+        {  650.0f, 27.30f },   // 1300 deg C
+        {  650.0f, 27.30f },   // 1350 deg C
+        {  650.0f, 27.30f },   // 1400 deg C
+        {  650.0f, 27.30f },   // 1450 deg C
+        {  650.0f, 27.30f },   // 1500 deg C
+        {  650.0f, 27.30f },   // 1550 deg C
+        {  650.0f, 27.30f },   // 1600 deg C
+        {  650.0f, 27.30f },   // 1650 deg C
+        {  650.0f, 27.30f },   // 1700 deg C
+    };
+
+    inline Properties at(float t) {
+        float x = (t - tMin) * (1.f / tStep);
+
+        if (x < 0)
+            x = 0;
+        else if (x > size - 1)
+            x = size - 1;
+
+        uint8_t i = (uint8_t) x;
+
+        if (i == size - 1)
+            i--;
+
+        Properties p[2];
+        memcpy_P(p, &table[i], sizeof(p));
+
+        float f = x - i;
+        return { p[0].C + f * (p[1].C - p[0].C), p[0].K + f * (p[1].K - p[0].K) };
+    }
+} // namespace material
+
+#endif
@@ -334,20 +334,20 @@ public:
         decButton.setup(decButtonPin);
     }
 
+    // Reads the buttons and reacts to them, without waiting - has to be called every few ms
     void update() {
-        do {
-            auto time = millis();
+        auto time = millis();
 
-            setButton.process(time);
-            leftButton.process(time);
-            rightButton.process(time);
-            incButton.process(time);
-            decButton.process(time);
+        setButton.process(time);
+        leftButton.process(time);
+        rightButton.process(time);
+        incButton.process(time);
+        decButton.process(time);
+    }
 
-            if (current) {
-                delay(50);
-            }
-        } while(current);
+    // whether a parameter is being edited - the menu owns the LCD then
+    bool active() const {
+        return current != nullptr;
     }
 
     void onParamUpdate(updateCb cb) {
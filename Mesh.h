@@ -4,88 +4,689 @@
 #include <BasicLinearAlgebra.h>
 #include <KeepMeAlive.h>
 #include "Tridiagonal.h"
+#include "Fixed.h"
 #include "IntegrationPoints.h"
+#include "MeshGrading.h"
+#include "MaterialTables.h"
 #include "print_util.h"
 
 using namespace prnt;
 
 class Input;
 
+/*
+    Time integration schemes. All of them solve a system with the same tridiagonal structure
+    in each step, they differ only in how the capacity and conduction terms are weighted
+    between its two sides:
+        BackwardEuler - first order, L-stable
+        CrankNicolson - second order, but rough initial conditions decay slowly and oscillate
+        Rannacher - Crank-Nicolson, with the first two steps replaced by four half steps of
+            backward Euler, which damp the oscillations
+        BDF2 - second order and L-stable, keeps the temperatures from one step back. The first
+            step is done with backward Euler
+*/
+enum class TimeScheme : uint8_t {
+    BackwardEuler,
+    CrankNicolson,
+    Rannacher,
+    BDF2,
+};
+
+template<typename T>
+struct MeshNode {
+    T t;
+    float r;
+};
+
+/*
+    What is left of the mid-side nodes of quadratic elements once they are condensed out of
+    the system - their coefficients, and their temperatures. Linear elements have none, so
+    these are empty then.
+*/
+template<int nElements, typename Coefficient, int order>
+struct CondensedTerms {};
+
+template<int nElements, typename Coefficient>
+struct CondensedTerms<nElements, Coefficient, 2> {
+    // coefficients of the mid-side temperature in the right-hand side rows of the end nodes
+    Coefficient rowI[nElements];
+    Coefficient rowJ[nElements];
+    // the new mid-side temperature is eI*tI + eM*tM + eJ*tJ of the old ones - hI*tI - hJ*tJ of the new ones
+    Coefficient eI[nElements];
+    Coefficient eM[nElements];
+    Coefficient eJ[nElements];
+    Coefficient hI[nElements];
+    Coefficient hJ[nElements];
+};
+
+template<int nElements, typename T, int order>
+struct CondensedNodes {};
+
+template<int nElements, typename T>
+struct CondensedNodes<nElements, T, 2> {
+    T mid[nElements];
+    T midPrevious[nElements];
+};
+
 /*
     Represents the one-dimensional FEM mesh.
     Stores all the nodes and has methods that generate their coordinates
     and preform the integration.
+
+    `T` is the number type of the node temperatures and of the per-step solve - `float`, or
+    `Q16_16` to avoid soft-float operations in each step. The assembly is done in float either
+    way, and its result is converted to the coefficient type (see `CoefficientType`).
+
+    `order` is 1 for linear elements and 2 for quadratic ones. A quadratic element has a third
+    node in its middle, which is statically condensed: it is eliminated from the element
+    equations before they are added to the system, and its temperature is recovered from the
+    end ones after the solve. So the system stays tridiagonal, over the end nodes only, and
+    `nodes` holds just those.
 */
-template<int nNodes>
-class Mesh {
+template<int nNodes, typename T = float, int order = 1>
+class Mesh : private CondensedNodes<nNodes - 1, T, order> {
+    static_assert(order == 1 || order == 2, "Only linear and quadratic elements are supported");
+
 public:
-    struct Node {
-        float t, r;
+    using value_type = T;
+    using Coefficient = typename CoefficientType<T>::type;
+    using Node = MeshNode<T>;
+
+    static constexpr int nElements = nNodes - 1;
+    // number of temperatures kept - the nodes, followed by the mid-side ones of quadratic elements
+    static constexpr int nTemperatures = order == 2 ? nNodes + nElements : nNodes;
+
+    /*
+        Matrices of the system solved in each time step. They depend only on the node radii,
+        time step and material, so within one cycle they can be assembled just once.
+
+        Every row is divided by its diagonal element of K, which does not change the solution,
+        but makes all the coefficients dimensionless and of the order of 1, whatever the radius,
+        time step and material are. That is what lets them be stored in fixed point.
+    */
+    struct System : CondensedTerms<nElements, Coefficient, order> {
+        // capacity, stiffness and boundary terms, already factorized
+        TridiagMat<nNodes, Coefficient> K;
+        // capacity terms only - multiplied by the node temperatures gives the right-hand side
+        TridiagMat<nNodes, Coefficient> C;
+        // coefficient of the ambient temperature in the last row of the right-hand side
+        Coefficient boundary;
+        // BDF2 system - C multiplies a combination of the current and previous temperatures
+        bool usesHistory;
     };
 
     Node nodes[nNodes];
+    System system;
+
+private:
+    // temperatures from the previous step, for BDF2
+    T previous[nNodes];
+
+    TimeScheme timeScheme = TimeScheme::BackwardEuler;
+    // steps left until the start-up of the scheme is done
+    uint8_t startupSteps = 0;
+
+    // parameters of the cached system, it is reassembled when the start-up is over
+    float cachedDTau = 0;
+    float cachedRMax = 0;
+    const Input* cachedInput = nullptr;
+
+public:
+    T& temperature(int i) {
+        if constexpr (order == 2) {
+            if (i >= nNodes)
+                return this->mid[i - nNodes];
+        }
+
+        return nodes[i].t;
+    }
+
+    const T& temperature(int i) const {
+        return const_cast<Mesh&>(*this).temperature(i);
+    }
+
+    // Sets all the temperatures to `t`
+    void fill(float t) {
+        for (int i = 0; i < nTemperatures; i++)
+            temperature(i) = T(t);
+    }
 
     void generate(float t0, float elemSize) {
         float r = 0;
         for (auto& node : nodes) {
-            node.t = t0;
             node.r = r;
 
             r += elemSize;
         }
+
+        fill(t0);
     }
 
-    void integrateStep(float dTau, float rMax, float tAmbient, const Input& input) {
-        TridiagMat<nNodes> K;
-        BLA::Matrix<nNodes> F;
+    // Lays out the nodes over [0, rMax] as given by `grading` (see MeshGrading.h)
+    void generate(float t0, float rMax, MeshGrading grading, float ratio) {
+        if (grading == MeshGrading::Uniform) {
+            generate(t0, rMax / (nNodes - 1));
+            return;
+        }
+
+        for (int i = 0; i < nNodes; i++)
+            nodes[i].r = gradedRadius(grading, i, nNodes - 1, rMax, ratio);
+
+        fill(t0);
+    }
+
+private:
+    /*
+        Stores row `i` of both matrices, scaled by the diagonal element of K. `kLower` and
+        `cLower` are the elements left of the diagonal, `kUpper` and `cUpper` right of it.
+        `boundary` is used only in the last row. `midLower` and `midUpper` are the right-hand
+        side coefficients of the condensed mid-side nodes of the elements left and right of the
+        node, for quadratic elements.
+    */
+    static void storeRow(
+        System& sys, int i,
+        float kLower, float kDiag, float kUpper,
+        float cLower, float cUpper, float boundary,
+        float midLower = 0, float midUpper = 0
+    ) {
+        const float scale = 1.f / kDiag;
 
-        K.Fill(0);
-        F.Fill(0);
+        auto& K = sys.K.storage;
+        auto& C = sys.C.storage;
+
+        /*
+            The conduction terms of a row sum up to zero, so the rows of K and C (plus the
+            boundary) have equal sums, and a uniform temperature equal to the ambient one stays
+            unchanged. The diagonal of C is computed from the other rounded coefficients, so
+            that this holds exactly, and rounding does not make the temperatures drift.
+        */
+        Coefficient sum = Coefficient(1);
+        K.diag(i) = Coefficient(1);
+
+        if (i > 0) {
+            K.lower(i-1) = Coefficient(kLower * scale);
+            C.lower(i-1) = Coefficient(cLower * scale);
+            sum += K.lower(i-1) - C.lower(i-1);
+        }
+
+        if (i < nNodes-1) {
+            K.upper(i) = Coefficient(kUpper * scale);
+            C.upper(i) = Coefficient(cUpper * scale);
+            sum += K.upper(i) - C.upper(i);
+        }
+        else {
+            sys.boundary = Coefficient(boundary * scale);
+            sum -= sys.boundary;
+        }
+
+        if constexpr (order == 2) {
+            if (i > 0) {
+                sys.rowJ[i-1] = Coefficient(midLower * scale);
+                sum -= sys.rowJ[i-1];
+            }
+
+            if (i < nNodes-1) {
+                sys.rowI[i] = Coefficient(midUpper * scale);
+                sum -= sys.rowI[i];
+            }
+        }
+
+        C.diag(i) = sum;
+    }
+
+    /*
+        The left-hand side is mass*M/dTau + lhs*A and the right-hand side matrix is
+        mass*M/dTau + rhs*A, where M holds the capacity terms and A the conduction and boundary
+        ones. `lhs - rhs` is always 1, so the ambient temperature coefficient does not change.
+    */
+    struct TimeWeights {
+        float mass, lhs, rhs;
+    };
+
+    static TimeWeights weightsOf(TimeScheme scheme) {
+        switch (scheme) {
+            case TimeScheme::CrankNicolson:
+            case TimeScheme::Rannacher: return { 1.f, .5f, -.5f };
+            // C is applied to (4*t - tPrev)/3, so it is scaled by 3/2 as well
+            case TimeScheme::BDF2: return { 1.5f, 1.f, 0.f };
+            default: return { 1.f, 1.f, 0.f };
+        }
+    }
+
+    template<unsigned scheme>
+    void assembleWith(System& sys, float dTau, float rMax, const Input& input, TimeScheme time) const {
+        using Scheme = GaussScheme<scheme>;
+
+        const TimeWeights w = weightsOf(time);
+        const float capacity = w.mass * input.C * input.Ro / dTau;
+        const float boundary = Scheme::nPoints * 2.f*input.alphaAir*rMax;
+
+        // the part of the current row that is already summed up, from the previous element
+        float kLower = 0, kDiag = 0;
+        float cLower = 0;
 
         for (int i = 0; i < nNodes-1; i++) {
-            BLA::Matrix<2,2> Klocal;
-            BLA::Matrix<2> Flocal;
-            Klocal.Fill(0);
-            Flocal.Fill(0);
+            float rI = nodes[i].r;
+            float rJ = nodes[i+1].r;
+
+            float dR = fabs(rI - rJ);
+
+            float cap = capacity * dR;
+            float C00 = cap * (rI*Scheme::mass00I + rJ*Scheme::mass00J);
+            float C01 = cap * (rI*Scheme::mass01I + rJ*Scheme::mass01J);
+            float C11 = cap * (rI*Scheme::mass11I + rJ*Scheme::mass11J);
+
+            float k = input.K / dR * (rI*Scheme::stiffI + rJ*Scheme::stiffJ);
+
+            // row i gets its last contribution from this element
+            storeRow(sys, i, kLower, kDiag + w.lhs*k + C00, -w.lhs*k + C01, cLower, -w.rhs*k + C01, boundary);
+
+            kLower = -w.lhs*k + C01;
+            kDiag = w.lhs*k + C11;
+            cLower = -w.rhs*k + C01;
+
+            watchdogTimer.reset();
+        }
+
+        storeRow(sys, nNodes-1, kLower, kDiag + w.lhs*boundary, 0, cLower, 0, boundary);
+        sys.usesHistory = time == TimeScheme::BDF2;
+
+        BLA::LUDecompose(sys.K);
+        watchdogTimer.reset();
+    }
+
+    /*
+        Assembly of quadratic elements. The 3x3 element matrices, H on the left-hand side and R
+        on the right one, are condensed: the mid-side row is solved for the mid-side temperature
+        and substituted into the end node rows, which leaves
+            H'ab = Hab - Ha1*H1b/H11
+        on the left and R'ab = Rab - Ha1*R1b/H11 on the right, plus R'a1 = Ra1 - Ha1*R11/H11
+        multiplying the old mid-side temperature.
+    */
+    template<unsigned scheme>
+    void assembleQuadratic(System& sys, float dTau, float rMax, const Input& input, TimeScheme time) const {
+        using Scheme = QuadraticGaussScheme<scheme>;
+
+        const TimeWeights w = weightsOf(time);
+        const float capacity = w.mass * input.C * input.Ro / dTau;
+        const float boundary = Scheme::nPoints * 2.f*input.alphaAir*rMax;
+
+        float kLower = 0, kDiag = 0;
+        float cLower = 0, midLower = 0;
+
+        for (int i = 0; i < nElements; i++) {
+            float rI = nodes[i].r;
+            float rJ = nodes[i+1].r;
+
+            float dR = fabs(rI - rJ);
+
+            float cap = capacity * dR;
+            float M00 = cap * (rI*Scheme::mass00I + rJ*Scheme::mass00J);
+            float M01 = cap * (rI*Scheme::mass01I + rJ*Scheme::mass01J);
+            float M02 = cap * (rI*Scheme::mass02I + rJ*Scheme::mass02J);
+            float M11 = cap * (rI*Scheme::mass11I + rJ*Scheme::mass11J);
+            float M12 = cap * (rI*Scheme::mass12I + rJ*Scheme::mass12J);
+            float M22 = cap * (rI*Scheme::mass22I + rJ*Scheme::mass22J);
 
-            auto& nodeI = nodes[i];
-            auto& nodeJ = nodes[i+1];
+            // the shape function slopes are taken over xi, d/dr = 2/dR * d/dxi, hence the 4/dR^2 -
+            // times the Jacobian dR that all the element integrals are taken with, as the capacity
+            // above and the linear elements are
+            float k = 4.f * input.K / dR;
+            float A00 = k * (rI*Scheme::stiff00I + rJ*Scheme::stiff00J);
+            float A01 = k * (rI*Scheme::stiff01I + rJ*Scheme::stiff01J);
+            float A02 = k * (rI*Scheme::stiff02I + rJ*Scheme::stiff02J);
+            float A11 = k * (rI*Scheme::stiff11I + rJ*Scheme::stiff11J);
+            float A12 = k * (rI*Scheme::stiff12I + rJ*Scheme::stiff12J);
+            float A22 = k * (rI*Scheme::stiff22I + rJ*Scheme::stiff22J);
 
-            float dR = fabs(nodeI.r - nodeJ.r);
+            float H00 = M00 + w.lhs*A00, R01 = M01 + w.rhs*A01;
+            float H01 = M01 + w.lhs*A01, R02 = M02 + w.rhs*A02;
+            float H02 = M02 + w.lhs*A02, R11 = M11 + w.rhs*A11;
+            float H11 = M11 + w.lhs*A11, R12 = M12 + w.rhs*A12;
+            float H12 = M12 + w.lhs*A12;
+            float H22 = M22 + w.lhs*A22;
 
-            float alphaAir = (i == nNodes-2) ? input.alphaAir : 0;
+            float scale = 1.f / H11;
+            float hI = H01 * scale;
+            float hJ = H12 * scale;
 
-            for (unsigned j = 0; j <= input.integrationScheme; j++) {
-                const auto& intPoint = IntegrationPoints::get(input.integrationScheme, j);
+            storeRow(
+                sys, i,
+                kLower, kDiag + H00 - hI*H01, H02 - hI*H12,
+                cLower, R02 - hI*R12, boundary,
+                midLower, R01 - hI*R11
+            );
 
-                float n0 = 0.5f * (1 - intPoint.xi);
-                float n1 = 0.5f * (1 + intPoint.xi);
+            kLower = H02 - hJ*H01;
+            kDiag = H22 - hJ*H12;
+            cLower = R02 - hJ*R01;
+            midLower = R12 - hJ*R11;
 
-                float r = nodeI.r * n0 + nodeJ.r * n1;
-                float t = nodeI.t * n0 + nodeJ.t * n1;
+            // the mid-side row is already scaled by its diagonal element
+            sys.hI[i] = Coefficient(hI);
+            sys.hJ[i] = Coefficient(hJ);
+            sys.eI[i] = Coefficient(R01 * scale);
+            sys.eJ[i] = Coefficient(R12 * scale);
+            // the mid-side row sums are equal on both sides too, see `storeRow`
+            sys.eM[i] = Coefficient(1) + sys.hI[i] + sys.hJ[i] - sys.eI[i] - sys.eJ[i];
 
-                auto tmp = input.C * input.Ro * dR * r * intPoint.weight;
+            watchdogTimer.reset();
+        }
+
+        storeRow(sys, nNodes-1, kLower, kDiag + w.lhs*boundary, 0, cLower, 0, boundary, midLower);
+        sys.usesHistory = time == TimeScheme::BDF2;
+
+        BLA::LUDecompose(sys.K);
+        watchdogTimer.reset();
+    }
 
-                Klocal(0,0) += input.K*r*intPoint.weight/dR + tmp*n0*n0/dTau;
-                Klocal(0,1) += -input.K*r*intPoint.weight/dR + tmp*n0*n1/dTau;
-                Klocal(1,0) = Klocal(0,1);
-                Klocal(1,1) += input.K*r*intPoint.weight/dR + tmp*n1*n1/dTau + 2.f*alphaAir*rMax;
+    template<unsigned scheme>
+    void assembleElements(System& sys, float dTau, float rMax, const Input& input, TimeScheme time) const {
+        if constexpr (order == 2)
+            assembleQuadratic<scheme>(sys, dTau, rMax, input, time);
+        else
+            assembleWith<scheme>(sys, dTau, rMax, input, time);
+    }
+
+    /*
+        Assembly with the heat capacity and conductivity taken from the tables in
+        MaterialTables.h, at the temperatures `at` of the nodes - the density is still the one
+        from the input. The properties change within an element, so the integrals cannot be
+        precomputed, and they are summed over the integration points here.
+    */
+    template<unsigned scheme>
+    void assembleWithMaterial(
+        System& sys, float dTau, float rMax, const Input& input, TimeScheme time, const float* at
+    ) const {
+        static_assert(order == 1, "Temperature-dependent properties are only supported with linear elements");
+        using Rule = GaussLegendre<scheme + 1>;
+
+        const TimeWeights w = weightsOf(time);
+        const float density = w.mass * input.Ro / dTau;
+        const float boundary = Rule::size * 2.f*input.alphaAir*rMax;
+
+        float kLower = 0, kDiag = 0;
+        float cLower = 0;
+
+        for (int i = 0; i < nNodes-1; i++) {
+            float rI = nodes[i].r;
+            float rJ = nodes[i+1].r;
 
-                Flocal(0) += tmp*t*n0/dTau;
-                Flocal(1) += tmp*t*n1/dTau + 2.f*alphaAir*rMax*tAmbient;
-                watchdogTimer.reset();
+            float dR = fabs(rI - rJ);
+
+            float C00 = 0, C01 = 0, C11 = 0;
+            float k = 0;
+
+            for (unsigned j = 0; j < Rule::size; j++) {
+                const auto p = Rule::point(j);
+                float n0 = 0.5f * (1 - p.xi);
+                float n1 = 0.5f * (1 + p.xi);
+
+                float wr = p.weight * (rI*n0 + rJ*n1);
+                float t = at[i]*n0 + at[i+1]*n1;
+
+                const auto properties = material::at(t);
+
+                float cap = wr * density * properties.C * dR;
+                C00 += cap * n0*n0;
+                C01 += cap * n0*n1;
+                C11 += cap * n1*n1;
+
+                k += wr * properties.K;
             }
 
-            F.template Submatrix<2, 1>(i, 0) += Flocal;
-            K.template Submatrix<2, 2>(i, i) += Klocal;
+            k /= dR;
+
+            storeRow(sys, i, kLower, kDiag + w.lhs*k + C00, -w.lhs*k + C01, cLower, -w.rhs*k + C01, boundary);
+
+            kLower = -w.lhs*k + C01;
+            kDiag = w.lhs*k + C11;
+            cLower = -w.rhs*k + C01;
+
+            watchdogTimer.reset();
         }
 
-        auto decomposition = BLA::LUDecompose(K);
-        auto t = BLA::LUSolve(decomposition, F);
+        storeRow(sys, nNodes-1, kLower, kDiag + w.lhs*boundary, 0, cLower, 0, boundary);
+        sys.usesHistory = time == TimeScheme::BDF2;
+
+        BLA::LUDecompose(sys.K);
         watchdogTimer.reset();
+    }
+
+    using AssembleFn = void (Mesh::*)(System&, float, float, const Input&, TimeScheme) const;
+    AssembleFn assembleFn = &Mesh::assembleElements<1>;
+    uint8_t integrationScheme = 1;
+
+public:
+    /*
+        Picks the assembly routine for the given integration scheme. Done once, when the
+        parameters change, so the assembly itself does not branch on the scheme.
+    */
+    void selectIntegrationScheme(unsigned scheme) {
+        integrationScheme = scheme < 1 ? 1 : scheme > 4 ? 4 : scheme;
+
+        switch (scheme) {
+            case 0:
+            case 1: assembleFn = &Mesh::assembleElements<1>; break;
+            case 2: assembleFn = &Mesh::assembleElements<2>; break;
+            case 3: assembleFn = &Mesh::assembleElements<3>; break;
+            default: assembleFn = &Mesh::assembleElements<4>; break;
+        }
+    }
+
+    void selectTimeScheme(TimeScheme scheme) {
+        timeScheme = scheme;
+    }
+
+    /*
+        Matrices of the semi-discrete system M*dT/dt + A*T = f(tAmbient), before any time
+        scheme is applied: M holds the capacity terms and A the conduction and boundary ones.
+        Both are symmetric, so only the diagonals and the elements below them are kept, and not
+        scaled, unlike the System.
+    */
+    struct Pencil {
+        float mDiag[nNodes];
+        float mLower[nNodes-1];
+        float aDiag[nNodes];
+        float aLower[nNodes-1];
+    };
+
+private:
+    template<unsigned scheme>
+    void assemblePencilWith(Pencil& p, float rMax, const Input& input) const {
+        using Scheme = GaussScheme<scheme>;
+
+        const float capacity = input.C * input.Ro;
+        const float boundary = Scheme::nPoints * 2.f*input.alphaAir*rMax;
+
+        for (int i = 0; i < nNodes; i++) {
+            p.mDiag[i] = 0;
+            p.aDiag[i] = 0;
+        }
+
+        for (int i = 0; i < nNodes-1; i++) {
+            float rI = nodes[i].r;
+            float rJ = nodes[i+1].r;
+
+            float dR = fabs(rI - rJ);
+
+            float cap = capacity * dR;
+            float k = input.K / dR * (rI*Scheme::stiffI + rJ*Scheme::stiffJ);
+
+            p.mDiag[i] += cap * (rI*Scheme::mass00I + rJ*Scheme::mass00J);
+            p.mLower[i] = cap * (rI*Scheme::mass01I + rJ*Scheme::mass01J);
+            p.mDiag[i+1] += cap * (rI*Scheme::mass11I + rJ*Scheme::mass11J);
+
+            p.aDiag[i] += k;
+            p.aLower[i] = -k;
+            p.aDiag[i+1] += k;
+        }
+
+        p.aDiag[nNodes-1] += boundary;
+    }
+
+public:
+    // Assembles the matrices of the semi-discrete system, for linear elements only
+    void assemble(Pencil& p, float rMax, const Input& input) const {
+        static_assert(order == 1, "The pencil is only assembled for linear elements");
+
+        switch (integrationScheme) {
+            case 1: assemblePencilWith<1>(p, rMax, input); break;
+            case 2: assemblePencilWith<2>(p, rMax, input); break;
+            case 3: assemblePencilWith<3>(p, rMax, input); break;
+            default: assemblePencilWith<4>(p, rMax, input); break;
+        }
+    }
+
+    // Assembles `sys` for steps of the selected time scheme, without its start-up
+    void assemble(System& sys, float dTau, float rMax, const Input& input) const {
+        (this->*assembleFn)(sys, dTau, rMax, input, timeScheme);
+    }
+
+    /*
+        Assembles `sys` for steps of the selected time scheme, with the temperature-dependent
+        material properties evaluated at the node temperatures `at`
+    */
+    void assemble(System& sys, float dTau, float rMax, const Input& input, const float* at) const {
+        switch (integrationScheme) {
+            case 1: assembleWithMaterial<1>(sys, dTau, rMax, input, timeScheme, at); break;
+            case 2: assembleWithMaterial<2>(sys, dTau, rMax, input, timeScheme, at); break;
+            case 3: assembleWithMaterial<3>(sys, dTau, rMax, input, timeScheme, at); break;
+            default: assembleWithMaterial<4>(sys, dTau, rMax, input, timeScheme, at); break;
+        }
+    }
+
+private:
+    uint8_t startupSubsteps() const {
+        return timeScheme == TimeScheme::Rannacher ? 2 : 1;
+    }
+
+    // Assembles `sys` for the current step - the scheme itself, or backward Euler during start-up
+    void assembleStep(System& sys, float dTau, float rMax, const Input& input) const {
+        if (startupSteps > 0)
+            (this->*assembleFn)(sys, dTau / startupSubsteps(), rMax, input, TimeScheme::BackwardEuler);
+        else
+            assemble(sys, dTau, rMax, input);
+    }
+
+    // Performs one step with a system from `assembleStep`
+    void advance(const System& sys, float tAmbient) {
+        if (startupSteps == 0) {
+            integrateStep(sys, tAmbient);
+            return;
+        }
+
+        for (uint8_t i = 0; i < startupSubsteps(); i++)
+            integrateStep(sys, tAmbient);
+
+        startupSteps--;
+    }
+
+public:
+    // Assembles the cached system, which is then used by `integrateStep(tAmbient)`
+    void assemble(float dTau, float rMax, const Input& input) {
+        cachedDTau = dTau;
+        cachedRMax = rMax;
+        cachedInput = &input;
+
+        assembleStep(system, dTau, rMax, input);
+    }
+
+    /*
+        Starts the time scheme over, from the current node temperatures. Has to be called
+        whenever they are reset, so that the start-up steps are done again.
+    */
+    void restartCycle() {
+        switch (timeScheme) {
+            case TimeScheme::Rannacher: startupSteps = 2; break;
+            case TimeScheme::BDF2: startupSteps = 1; break;
+            default: startupSteps = 0; break;
+        }
 
         for (int i = 0; i < nNodes; i++)
-            nodes[i].t = t(i);
+            previous[i] = nodes[i].t;
+
+        if constexpr (order == 2) {
+            for (int i = 0; i < nElements; i++)
+                this->midPrevious[i] = this->mid[i];
+        }
+
+        if (cachedInput != nullptr && startupSteps > 0)
+            assembleStep(system, cachedDTau, cachedRMax, *cachedInput);
+    }
+
+    /*
+        Advances the node temperatures by one time step using an already assembled system,
+        which costs just a few multiply-adds per node.
+    */
+    void integrateStep(const System& sys, float tAmbient) {
+        const auto& C = sys.C.storage;
+        const Coefficient third = Coefficient(1.f/3);
+        T rhs[nNodes];
+        T t[nNodes];
+
+        if (sys.usesHistory) {
+            for (int i = 0; i < nNodes; i++)
+                rhs[i] = nodes[i].t + third * (nodes[i].t - previous[i]);
+        }
+        else {
+            for (int i = 0; i < nNodes; i++)
+                rhs[i] = nodes[i].t;
+        }
+
+        for (int i = 0; i < nNodes; i++) {
+            t[i] = C.diag(i) * rhs[i];
+
+            if (i > 0)
+                t[i] += C.lower(i-1) * rhs[i-1];
+
+            if (i < nNodes-1)
+                t[i] += C.upper(i) * rhs[i+1];
+        }
+
+        if constexpr (order == 2) {
+            for (int i = 0; i < nElements; i++) {
+                T& mid = this->mid[i];
+                T m = sys.usesHistory ? mid + third * (mid - this->midPrevious[i]) : mid;
+
+                t[i] += sys.rowI[i] * m;
+                t[i+1] += sys.rowJ[i] * m;
+
+                // the part of the new mid-side temperature that is known before the solve
+                this->midPrevious[i] = mid;
+                mid = sys.eI[i] * rhs[i] + sys.eM[i] * m + sys.eJ[i] * rhs[i+1];
+            }
+        }
+
+        t[nNodes-1] += sys.boundary * T(tAmbient);
+
+        sys.K.storage.solve(t);
+
+        for (int i = 0; i < nNodes; i++) {
+            previous[i] = nodes[i].t;
+            nodes[i].t = t[i];
+        }
+
+        if constexpr (order == 2) {
+            for (int i = 0; i < nElements; i++)
+                this->mid[i] -= sys.hI[i] * t[i] + sys.hJ[i] * t[i+1];
+        }
+    }
+
+    // Performs a step with the cached system
+    void integrateStep(float tAmbient) {
+        bool startup = startupSteps > 0;
+        advance(system, tAmbient);
+
+        if (startup && startupSteps == 0)
+            assembleStep(system, cachedDTau, cachedRMax, *cachedInput);
+    }
+
+    // Assembles the system from scratch and then performs the step
+    void integrateStep(float dTau, float rMax, float tAmbient, const Input& input) {
+        System sys;
+        assembleStep(sys, dTau, rMax, input);
+        advance(sys, tAmbient);
     }
 };
 
@@ -0,0 +1,43 @@
+#ifndef MESH_GRADING_HEADER_GUARD
+#define MESH_GRADING_HEADER_GUARD
+
+#include <math.h>
+
+/*
+    Ways of laying out the nodes over the radius. The graded ones put more of them near the
+    surface, where the heat flows in and the temperature gradient is the steepest:
+        Uniform - elements of equal size
+        Geometric - element sizes form a geometric progression, the one at the surface
+            is `ratio` times the size of the one at the axis
+        Chebyshev - r = rMax * sin(pi/2 * i/nElements), like the spacing of Chebyshev
+            nodes near the end of the interval
+*/
+enum class MeshGrading : uint8_t {
+    Uniform,
+    Geometric,
+    Chebyshev,
+};
+
+// Radius of node `i` of a mesh of `nElements` elements over [0, rMax]
+inline float gradedRadius(MeshGrading grading, int i, int nElements, float rMax, float ratio) {
+    switch (grading) {
+        case MeshGrading::Geometric: {
+            float q = nElements > 1 ? pow(ratio, 1.f / (nElements - 1)) : 1.f;
+
+            if (fabs(q - 1.f) < 1e-6f)
+                break;
+
+            return rMax * (pow(q, i) - 1.f) / (pow(q, nElements) - 1.f);
+        }
+
+        case MeshGrading::Chebyshev:
+            return rMax * sin(float(M_PI) / 2 * i / nElements);
+
+        default:
+            break;
+    }
+
+    return rMax * i / nElements;
+}
+
+#endif
@@ -0,0 +1,238 @@
+#ifndef MODAL_SOLVER_HEADER_GUARD
+#define MODAL_SOLVER_HEADER_GUARD
+
+#include <KeepMeAlive.h>
+#include "Mesh.h"
+
+/*
+    Advances a mesh of linear elements by any time interval in one step, without solving a
+    system and without a time discretization error.
+
+    With constant material properties and a constant ambient temperature, the difference
+    u = T - tAmbient follows M*du/dt + A*u = 0 (see Mesh::Pencil), which decouples in the
+    eigenvectors of A*v = lambda*M*v. Normalized so that v'*M*v = 1,
+        T(tau + dTau) = tAmbient + sum_k exp(-lambda_k*dTau) * v_k * (v_k'*M*u(tau))
+    so a step is two passes over the `nModes` kept modes - O(nNodes*nModes).
+
+    `decompose` finds the smallest eigenvalues by bisection on the Sturm count of the pencil
+    (the number of negative pivots of A - lambda*M is the number of eigenvalues below lambda),
+    and the eigenvectors by inverse iteration, all in O(nNodes) per evaluation with the
+    tridiagonal matrices. The modes left out decay at least as fast as exp(-lambda*dTau) with
+    the first of their eigenvalues (`cutoff`), and are taken as already decayed - which holds
+    for steps much longer than 1/cutoff. With `nModes == nNodes` nothing is left out.
+*/
+template<int nNodes, typename T, int nModes = nNodes>
+class ModalSolver {
+    static_assert(nModes > 0 && nModes <= nNodes, "There are nNodes modes at most");
+
+public:
+    using MeshT = Mesh<nNodes, T>;
+
+private:
+    MeshT& mesh;
+    typename MeshT::Pencil pencil;
+
+    // [1/s], ascending
+    float lambda[nModes];
+    float modes[nModes][nNodes];
+    float firstDropped = INFINITY;
+
+    // exp(-lambda*dTau) of the last step length
+    float decay[nModes];
+    float decayStep = NAN;
+
+    // number of eigenvalues of the pencil below `shift`
+    int sturmCount(float shift) const {
+        const auto& p = pencil;
+        int count = 0;
+        float d = 1;
+
+        for (int i = 0; i < nNodes; i++) {
+            float pivot = p.aDiag[i] - shift*p.mDiag[i];
+
+            if (i > 0) {
+                float off = p.aLower[i-1] - shift*p.mLower[i-1];
+                pivot -= off*off / d;
+            }
+
+            // a zero pivot is taken as a tiny positive one
+            if (pivot == 0)
+                pivot = 1e-30f;
+
+            if (pivot < 0)
+                count++;
+
+            d = pivot;
+        }
+
+        return count;
+    }
+
+    // The eigenvalue number `k`, counted from 0
+    float eigenvalue(int k) const {
+        float lo = 0, hi = 1;
+
+        while (sturmCount(hi) <= k)
+            hi *= 2;
+
+        // down to the float resolution - the interval stops shrinking then
+        while (true) {
+            float mid = 0.5f * (lo + hi);
+
+            if (mid <= lo || mid >= hi || hi - lo <= 1e-6f * hi)
+                return mid;
+
+            if (sturmCount(mid) > k)
+                hi = mid;
+            else
+                lo = mid;
+        }
+    }
+
+    // y = M*x
+    void multiplyM(const float* x, float* y) const {
+        const auto& p = pencil;
+
+        for (int i = 0; i < nNodes; i++) {
+            y[i] = p.mDiag[i] * x[i];
+
+            if (i > 0)
+                y[i] += p.mLower[i-1] * x[i-1];
+
+            if (i < nNodes-1)
+                y[i] += p.mLower[i] * x[i+1];
+        }
+    }
+
+    /*
+        Inverse iteration for the mode `k` with the eigenvalue `shift`: solves
+        (A - shift*M)*x = M*v a few times, keeping x M-orthogonal to the previous modes. The
+        matrix is nearly singular, which is what makes the mode dominate after a single solve.
+    */
+    void findMode(int k, float shift) {
+        const auto& p = pencil;
+        float lower[nNodes-1], diag[nNodes], upper[nNodes-1];
+
+        for (int i = 0; i < nNodes; i++) {
+            diag[i] = p.aDiag[i] - shift*p.mDiag[i];
+
+            if (i < nNodes-1)
+                lower[i] = upper[i] = p.aLower[i] - shift*p.mLower[i];
+        }
+
+        // zero pivots would be replaced anyway, so factorize by hand. The shift is the
+        // eigenvalue to the float resolution, so a pivot may cancel out completely - it is kept
+        // at the rounding error of its row, or the solution would overflow
+        for (int i = 0; i < nNodes; i++) {
+            if (i > 0)
+                diag[i] -= lower[i-1] * upper[i-1];
+
+            float tiny = 1e-6f * (p.aDiag[i] + shift*p.mDiag[i]);
+
+            if (fabs(diag[i]) < tiny)
+                diag[i] = diag[i] < 0 ? -tiny : tiny;
+
+            diag[i] = 1.f / diag[i];
+
+            if (i < nNodes-1)
+                lower[i] *= diag[i];
+        }
+
+        float* v = modes[k];
+        float mv[nNodes];
+
+        // the start has components in all the modes - they alternate in sign ever more often
+        for (int i = 0; i < nNodes; i++)
+            v[i] = 1.f + 0.1f * i;
+
+        for (uint8_t iteration = 0; iteration < 3; iteration++) {
+            multiplyM(v, mv);
+            tridiag::solve(lower, diag, upper, mv, nNodes);
+
+            for (int i = 0; i < nNodes; i++)
+                v[i] = mv[i];
+
+            for (int j = 0; j < k; j++) {
+                multiplyM(modes[j], mv);
+                float dot = 0;
+
+                for (int i = 0; i < nNodes; i++)
+                    dot += v[i] * mv[i];
+
+                for (int i = 0; i < nNodes; i++)
+                    v[i] -= dot * modes[j][i];
+            }
+
+            multiplyM(v, mv);
+            float norm = 0;
+
+            for (int i = 0; i < nNodes; i++)
+                norm += v[i] * mv[i];
+
+            norm = 1.f / sqrt(norm);
+
+            for (int i = 0; i < nNodes; i++)
+                v[i] *= norm;
+        }
+    }
+
+public:
+    explicit ModalSolver(MeshT& mesh): mesh(mesh) {}
+
+    // Finds the modes of the mesh with the given material, done once per parameter change
+    void decompose(float rMax, const Input& input) {
+        mesh.assemble(pencil, rMax, input);
+
+        for (int k = 0; k < nModes; k++) {
+            lambda[k] = eigenvalue(k);
+            findMode(k, lambda[k]);
+            watchdogTimer.reset();
+        }
+
+        firstDropped = nModes < nNodes ? eigenvalue(nModes) : INFINITY;
+        decayStep = NAN;
+    }
+
+    // Advances the temperatures by `dTau` [s] with the ambient temperature `tAmbient`
+    void step(float dTau, float tAmbient) {
+        if (dTau != decayStep) {
+            for (int k = 0; k < nModes; k++)
+                decay[k] = exp(-lambda[k] * dTau);
+
+            decayStep = dTau;
+        }
+
+        float u[nNodes], mu[nNodes];
+
+        for (int i = 0; i < nNodes; i++)
+            u[i] = (float) mesh.nodes[i].t - tAmbient;
+
+        multiplyM(u, mu);
+
+        for (int i = 0; i < nNodes; i++)
+            u[i] = tAmbient;
+
+        for (int k = 0; k < nModes; k++) {
+            float c = 0;
+
+            for (int i = 0; i < nNodes; i++)
+                c += modes[k][i] * mu[i];
+
+            c *= decay[k];
+
+            for (int i = 0; i < nNodes; i++)
+                u[i] += c * modes[k][i];
+        }
+
+        for (int i = 0; i < nNodes; i++)
+            mesh.nodes[i].t = T(u[i]);
+    }
+
+    // [1/s]
+    float eigenvalueOf(int k) const { return lambda[k]; }
+
+    // the smallest eigenvalue of the modes left out [1/s], infinity if there are none
+    float cutoff() const { return firstDropped; }
+};
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef ARENA_HEADER_GUARD
+#define ARENA_HEADER_GUARD
+
+#include <stddef.h>
+#include <memory>
+#include <new>
+#include <vector>
+
+/*
+    Bump allocator for the runtime-sized solver. Memory is handed out from a list of blocks
+    and is never freed one allocation at a time - instead the arena is rewound to a previously
+    taken mark. Blocks are kept when rewinding, so once the first time step has run, all the
+    following ones reuse the same memory and do not allocate at all.
+*/
+class Arena {
+public:
+    struct Mark {
+        size_t block;
+        size_t offset;
+    };
+
+private:
+    struct AlignedDelete {
+        void operator()(std::byte* ptr) const {
+            ::operator delete(ptr, std::align_val_t(alignment));
+        }
+    };
+
+    struct Block {
+        std::unique_ptr<std::byte, AlignedDelete> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t offset = 0;
+    size_t blockSize;
+
+    static size_t alignUp(size_t value, size_t alignment) {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+public:
+    static constexpr size_t alignment = 64;
+
+    explicit Arena(size_t blockSize = 64 * 1024): blockSize(blockSize) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(size_t bytes) {
+        bytes = alignUp(bytes, alignment);
+
+        while (current < blocks.size()) {
+            auto& block = blocks[current];
+
+            if (offset + bytes <= block.size) {
+                void* ptr = block.data.get() + offset;
+                offset += bytes;
+                return ptr;
+            }
+
+            current++;
+            offset = 0;
+        }
+
+        size_t size = bytes > blockSize ? bytes : blockSize;
+        auto data = static_cast<std::byte*>(::operator new(size, std::align_val_t(alignment)));
+        blocks.push_back({ std::unique_ptr<std::byte, AlignedDelete>(data), size });
+
+        current = blocks.size() - 1;
+        offset = bytes;
+        return blocks.back().data.get();
+    }
+
+    // Returns uninitialized storage for `n` objects of a trivial type
+    template<typename T>
+    T* allocate(size_t n) {
+        static_assert(alignof(T) <= alignment, "Arena alignment is too small for this type");
+        return static_cast<T*>(allocate(n * sizeof(T)));
+    }
+
+    Mark mark() const {
+        return { current, offset };
+    }
+
+    void release(Mark m) {
+        current = m.block;
+        offset = m.offset;
+    }
+
+    void reset() {
+        release({ 0, 0 });
+    }
+
+    size_t capacity() const {
+        size_t total = 0;
+
+        for (const auto& block : blocks)
+            total += block.size;
+
+        return total;
+    }
+
+    /*
+        Releases everything allocated after it was created, when it goes out of scope.
+        Used for the per-step scratch memory.
+    */
+    class Scope {
+        Arena& arena;
+        Mark m;
+
+    public:
+        explicit Scope(Arena& arena): arena(arena), m(arena.mark()) {}
+        ~Scope() { arena.release(m); }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+};
+
+#endif
@@ -129,6 +129,9 @@ using Zeros = Matrix<rows, cols, Zero<ElemT>>;
 template <int rows, int cols, int tableSize = cols, class ElemT = float>
 using SparseMatrix = Matrix<rows, cols, Sparse<cols, tableSize, ElemT>>;
 
+template <int dim, int kl, int ku, class ElemT = float>
+using BandedMatrix = Matrix<dim, dim, Banded<dim, kl, ku, ElemT>>;
+
 template <int dim, class ElemT = float>
 using PermutationMatrix = Matrix<dim, dim, Permutation<dim, ElemT>>;
 
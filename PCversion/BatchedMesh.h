@@ -0,0 +1,202 @@
+#ifndef BATCHED_MESH_HEADER_GUARD
+#define BATCHED_MESH_HEADER_GUARD
+
+#include <math.h>
+#include "material.h"
+#include "IntegrationPoints.h"
+#include "MeshGrading.h"
+
+// Number of float lanes of the widest vector unit the compiler is allowed to target
+#if defined(__AVX512F__)
+constexpr int simdLanes = 16;
+#elif defined(__AVX__)
+constexpr int simdLanes = 8;
+#else
+constexpr int simdLanes = 4;
+#endif
+
+/*
+    Advances `nLanes` independent meshes (scenarios) in lockstep.
+
+    All the data is stored as structure of arrays, with one lane per scenario: every per-node
+    quantity is an array of `nLanes` floats. The innermost loops of assembly, factorization and
+    solve always run across the lanes, so each of them compiles to a few vector instructions
+    (AVX2 or AVX-512, depending on the target flags) instead of a scalar loop over a tiny mesh.
+
+    Every scenario has its own radius, initial and ambient temperature, time step and material.
+    Only the integration scheme is shared, because it selects the assembly routine.
+    Like the cached `Mesh` mode, the system is assembled and factorized once per cycle, and then
+    each step only forms the right-hand side and does the substitution.
+*/
+template<int nNodes, int nLanes = simdLanes>
+class BatchedMesh {
+public:
+    // Per-scenario parameters
+    alignas(64) float t0[nLanes];
+    alignas(64) float rMax[nLanes];
+    alignas(64) float dTau[nLanes];
+    alignas(64) float tAmbient[nLanes];
+    alignas(64) float C[nLanes];
+    alignas(64) float Ro[nLanes];
+    alignas(64) float K[nLanes];
+    alignas(64) float alphaAir[nLanes];
+
+    // Node state
+    alignas(64) float t[nNodes][nLanes];
+    alignas(64) float r[nNodes][nLanes];
+
+private:
+    // Factorized system matrix: `hInv` holds reciprocal pivots, `hMul` the elimination
+    // multipliers and `hOff` the (symmetric) off-diagonal
+    alignas(64) float hInv[nNodes][nLanes];
+    alignas(64) float hMul[nNodes-1][nLanes];
+    alignas(64) float hOff[nNodes-1][nLanes];
+
+    // Capacity matrix and the boundary coefficient
+    alignas(64) float cDiag[nNodes][nLanes];
+    alignas(64) float cOff[nNodes-1][nLanes];
+    alignas(64) float boundary[nLanes];
+
+public:
+    static constexpr int lanes = nLanes;
+
+    void setScenario(int lane, float t0, float rMax, float dTau, float tAmbient, const Material& material) {
+        this->t0[lane] = t0;
+        this->rMax[lane] = rMax;
+        this->dTau[lane] = dTau;
+        this->tAmbient[lane] = tAmbient;
+        C[lane] = material.C;
+        Ro[lane] = material.Ro;
+        K[lane] = material.K;
+        alphaAir[lane] = material.alphaAir;
+    }
+
+    // Lays out the meshes over the radius of every scenario, all with the same grading (see
+    // MeshGrading.h), and resets the temperatures
+    void generate(MeshGrading grading = MeshGrading::Uniform, float ratio = 1) {
+        if (grading != MeshGrading::Uniform) {
+            for (int i = 0; i < nNodes; i++)
+                for (int l = 0; l < nLanes; l++)
+                    r[i][l] = gradedRadius(grading, i, nNodes - 1, rMax[l], ratio);
+
+            reset();
+            return;
+        }
+
+        alignas(64) float elemSize[nLanes];
+        alignas(64) float radius[nLanes];
+
+        for (int l = 0; l < nLanes; l++) {
+            elemSize[l] = rMax[l] / (nNodes - 1);
+            radius[l] = 0;
+        }
+
+        for (int i = 0; i < nNodes; i++) {
+            for (int l = 0; l < nLanes; l++) {
+                r[i][l] = radius[l];
+                radius[l] += elemSize[l];
+            }
+        }
+
+        reset();
+    }
+
+    void reset() {
+        for (int i = 0; i < nNodes; i++)
+            for (int l = 0; l < nLanes; l++)
+                t[i][l] = t0[l];
+    }
+
+    void assemble(unsigned integrationScheme) {
+        switch (integrationScheme) {
+            case 0:
+            case 1: assembleWith<1>(); break;
+            case 2: assembleWith<2>(); break;
+            case 3: assembleWith<3>(); break;
+            default: assembleWith<4>(); break;
+        }
+    }
+
+private:
+    template<unsigned scheme>
+    void assembleWith() {
+        using Scheme = GaussScheme<scheme>;
+
+        alignas(64) float hDiag[nNodes][nLanes] = {};
+
+        for (int i = 0; i < nNodes; i++)
+            for (int l = 0; l < nLanes; l++)
+                cDiag[i][l] = 0;
+
+        for (int i = 0; i < nNodes-1; i++) {
+            for (int l = 0; l < nLanes; l++) {
+                float rI = r[i][l];
+                float rJ = r[i+1][l];
+                float dR = fabsf(rJ - rI);
+
+                float cap = C[l] * Ro[l] * dR / dTau[l];
+                float C00 = cap * (rI*Scheme::mass00I + rJ*Scheme::mass00J);
+                float C01 = cap * (rI*Scheme::mass01I + rJ*Scheme::mass01J);
+                float C11 = cap * (rI*Scheme::mass11I + rJ*Scheme::mass11J);
+
+                float k = K[l] / dR * (rI*Scheme::stiffI + rJ*Scheme::stiffJ);
+
+                cDiag[i][l] += C00;
+                cOff[i][l] = C01;
+                cDiag[i+1][l] += C11;
+
+                hDiag[i][l] += k + C00;
+                hOff[i][l] = -k + C01;
+                hDiag[i+1][l] += k + C11;
+            }
+        }
+
+        // the boundary term is evaluated at the radius of each integration point of the last element
+        for (int l = 0; l < nLanes; l++) {
+            boundary[l] = 2.f * alphaAir[l] * (r[nNodes-2][l]*Scheme::pointSumI + r[nNodes-1][l]*Scheme::pointSumJ);
+            hDiag[nNodes-1][l] += boundary[l];
+        }
+
+        // Thomas factorization, without pivoting, of all the systems at once
+        for (int l = 0; l < nLanes; l++)
+            hInv[0][l] = 1.f / hDiag[0][l];
+
+        for (int i = 0; i < nNodes-1; i++) {
+            for (int l = 0; l < nLanes; l++) {
+                hMul[i][l] = hOff[i][l] * hInv[i][l];
+                hInv[i+1][l] = 1.f / (hDiag[i+1][l] - hMul[i][l] * hOff[i][l]);
+            }
+        }
+    }
+
+public:
+    // Advances the node temperatures of all the scenarios by one time step
+    void integrateStep() {
+        alignas(64) float x[nNodes][nLanes];
+
+        for (int l = 0; l < nLanes; l++)
+            x[0][l] = cDiag[0][l] * t[0][l] + cOff[0][l] * t[1][l];
+
+        for (int i = 1; i < nNodes-1; i++)
+            for (int l = 0; l < nLanes; l++)
+                x[i][l] = cOff[i-1][l] * t[i-1][l] + cDiag[i][l] * t[i][l] + cOff[i][l] * t[i+1][l];
+
+        for (int l = 0; l < nLanes; l++) {
+            x[nNodes-1][l] = cOff[nNodes-2][l] * t[nNodes-2][l] + cDiag[nNodes-1][l] * t[nNodes-1][l]
+                + boundary[l] * tAmbient[l];
+        }
+
+        for (int i = 1; i < nNodes; i++)
+            for (int l = 0; l < nLanes; l++)
+                x[i][l] -= hMul[i-1][l] * x[i-1][l];
+
+        for (int l = 0; l < nLanes; l++)
+            t[nNodes-1][l] = x[nNodes-1][l] * hInv[nNodes-1][l];
+
+        for (int i = nNodes-2; i >= 0; i--)
+            for (int l = 0; l < nLanes; l++)
+                t[i][l] = (x[i][l] - hOff[i][l] * t[i+1][l]) * hInv[i][l];
+    }
+};
+
+#endif
@@ -0,0 +1,345 @@
+﻿#ifndef BENCHMARK_HEADER_GUARD
+#define BENCHMARK_HEADER_GUARD
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+    A small benchmark harness: every benchmark is warmed up, then timed in a number of
+    repetitions, each long enough for the clock resolution not to matter. The per-operation
+    times of the repetitions are summarized, and on Linux the CPU cycles and instructions are
+    counted too, where the kernel allows it (see perf_event_paranoid).
+
+    The results are printed as a table and can be written as JSON, one benchmark per line in a
+    fixed order, so that the files from two commits can be compared with a plain diff.
+*/
+namespace bench {
+    using Clock = std::chrono::steady_clock;
+    using Params = std::vector<std::pair<std::string, std::string>>;
+
+    // Keeps the compiler from optimizing away a value that is never used otherwise
+    template<typename T>
+    inline void doNotOptimize(const T& value) {
+        #if defined(__GNUC__)
+        asm volatile("" : : "g"(&value) : "memory");
+        #else
+        static volatile const void* sink;
+        sink = &value;
+        #endif
+    }
+
+    struct Summary {
+        double min, median, mean, stddev, max;
+    };
+
+    inline Summary summarize(std::vector<double> samples) {
+        std::sort(samples.begin(), samples.end());
+        size_t n = samples.size();
+
+        double sum = 0;
+        for (double s : samples)
+            sum += s;
+
+        double mean = sum / n;
+        double squares = 0;
+
+        for (double s : samples)
+            squares += (s - mean) * (s - mean);
+
+        double median = n % 2 ? samples[n/2] : (samples[n/2 - 1] + samples[n/2]) / 2;
+        double stddev = n > 1 ? std::sqrt(squares / (n - 1)) : 0;
+
+        return { samples.front(), median, mean, stddev, samples.back() };
+    }
+
+    // Hardware counters of the calling thread, disabled when they cannot be opened
+    class Counters {
+        int cyclesFd = -1;
+        int instructionsFd = -1;
+
+        #if defined(__linux__)
+        static int open(uint64_t config, int group) {
+            perf_event_attr attr{};
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.size = sizeof(attr);
+            attr.config = config;
+            attr.disabled = group == -1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP;
+
+            return (int) syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+        }
+        #endif
+
+    public:
+        struct Reading {
+            uint64_t cycles = 0;
+            uint64_t instructions = 0;
+        };
+
+        Counters() {
+            #if defined(__linux__)
+            cyclesFd = open(PERF_COUNT_HW_CPU_CYCLES, -1);
+
+            if (cyclesFd >= 0)
+                instructionsFd = open(PERF_COUNT_HW_INSTRUCTIONS, cyclesFd);
+
+            if (instructionsFd < 0 && cyclesFd >= 0) {
+                close(cyclesFd);
+                cyclesFd = -1;
+            }
+            #endif
+        }
+
+        ~Counters() {
+            #if defined(__linux__)
+            if (instructionsFd >= 0)
+                close(instructionsFd);
+
+            if (cyclesFd >= 0)
+                close(cyclesFd);
+            #endif
+        }
+
+        Counters(const Counters&) = delete;
+        Counters& operator=(const Counters&) = delete;
+
+        bool available() const { return cyclesFd >= 0; }
+
+        void start() {
+            #if defined(__linux__)
+            if (available()) {
+                ioctl(cyclesFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+                ioctl(cyclesFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            }
+            #endif
+        }
+
+        Reading stop() {
+            Reading reading;
+
+            #if defined(__linux__)
+            if (available()) {
+                ioctl(cyclesFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+                // number of events, then the values in the order they were added to the group
+                uint64_t values[3] = {};
+
+                if (read(cyclesFd, values, sizeof(values)) == (ssize_t) sizeof(values)) {
+                    reading.cycles = values[1];
+                    reading.instructions = values[2];
+                }
+            }
+            #endif
+
+            return reading;
+        }
+    };
+
+    struct Options {
+        int repetitions = 10;
+        // minimal duration of one repetition and of the warm-up [s]
+        double minTime = 0.01;
+        double warmupTime = 0.05;
+        // only the benchmarks whose full name contains it are run
+        std::string filter;
+        // stored in the JSON file, e.g. the commit the results belong to
+        std::string label;
+    };
+
+    struct Result {
+        std::string name;
+        Params params;
+        long iterations;
+        // [ns per operation]
+        Summary time;
+        bool counted;
+        double cyclesPerOp;
+        double instructionsPerOp;
+    };
+
+    class Runner {
+        Options options;
+        Counters counters;
+        std::vector<Result> results;
+
+        static std::string fullName(const std::string& name, const Params& params) {
+            std::string full = name;
+
+            for (const auto& p : params)
+                full += "/" + p.first + ":" + p.second;
+
+            return full;
+        }
+
+        template<class Fn>
+        static double timeBatch(Fn& fn, long iterations) {
+            auto start = Clock::now();
+
+            for (long i = 0; i < iterations; i++)
+                fn();
+
+            return std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+    public:
+        explicit Runner(const Options& options): options(options) {}
+
+        bool countersAvailable() const { return counters.available(); }
+
+        /*
+            Runs `fn` - one operation - as the benchmark `name`. The warm-up also finds the
+            number of operations that makes a repetition last at least `minTime`.
+        */
+        template<class Fn>
+        void run(const std::string& name, const Params& params, Fn&& fn) {
+            std::string full = fullName(name, params);
+
+            if (full.find(options.filter) == std::string::npos)
+                return;
+
+            long iterations = 1;
+            double warmed = 0;
+
+            while (true) {
+                double elapsed = timeBatch(fn, iterations);
+                warmed += elapsed;
+
+                if (elapsed >= options.minTime && warmed >= options.warmupTime)
+                    break;
+
+                if (elapsed < options.minTime)
+                    iterations *= 2;
+            }
+
+            std::vector<double> samples;
+            Counters::Reading total;
+
+            for (int r = 0; r < options.repetitions; r++) {
+                counters.start();
+                double elapsed = timeBatch(fn, iterations);
+                auto reading = counters.stop();
+
+                samples.push_back(elapsed * 1e9 / iterations);
+                total.cycles += reading.cycles;
+                total.instructions += reading.instructions;
+            }
+
+            double ops = (double) iterations * options.repetitions;
+
+            Result result{
+                name, params, iterations, summarize(samples),
+                counters.available(), total.cycles / ops, total.instructions / ops
+            };
+
+            print(std::cout, full, result);
+            results.push_back(result);
+        }
+
+        static void print(std::ostream& out, const std::string& full, const Result& r) {
+            out << std::left << std::setw(84) << full << std::right << std::fixed
+                << std::setprecision(1)
+                << std::setw(12) << r.time.median << " ns"
+                << std::setw(12) << r.time.min << " ns"
+                << std::setw(8) << (r.time.mean > 0 ? 100 * r.time.stddev / r.time.mean : 0) << " %";
+
+            if (r.counted) {
+                out << std::setw(12) << r.cyclesPerOp << " cyc"
+                    << std::setw(8) << std::setprecision(2)
+                    << (r.cyclesPerOp > 0 ? r.instructionsPerOp / r.cyclesPerOp : 0) << " IPC";
+            }
+
+            out << std::defaultfloat << '\n';
+        }
+
+        static void printHeader(std::ostream& out, bool counted) {
+            out << std::left << std::setw(84) << "benchmark" << std::right
+                << std::setw(15) << "median" << std::setw(15) << "min" << std::setw(10) << "stddev";
+
+            if (counted)
+                out << std::setw(16) << "cycles/op" << std::setw(12) << "";
+
+            out << '\n';
+        }
+
+        static void writeString(std::ostream& out, const std::string& s) {
+            out << '"';
+
+            for (char c : s) {
+                if (c == '"' || c == '\\')
+                    out << '\\';
+
+                out << c;
+            }
+
+            out << '"';
+        }
+
+        void writeJson(std::ostream& out) const {
+            std::time_t now = std::time(nullptr);
+            char date[32];
+            std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+            out << "{\n  \"context\": {\"label\": ";
+            writeString(out, options.label);
+            out << ", \"date\": \"" << date << "\", \"compiler\": ";
+            #if defined(__VERSION__)
+            writeString(out, __VERSION__);
+            #else
+            writeString(out, "unknown");
+            #endif
+            out << ", \"repetitions\": " << options.repetitions
+                << ", \"counters\": " << (counters.available() ? "true" : "false") << "},\n"
+                << "  \"benchmarks\": [\n";
+
+            out << std::setprecision(6);
+
+            for (size_t i = 0; i < results.size(); i++) {
+                const auto& r = results[i];
+
+                out << "    {\"name\": ";
+                writeString(out, fullName(r.name, r.params));
+                out << ", \"params\": {";
+
+                for (size_t p = 0; p < r.params.size(); p++) {
+                    out << (p ? ", " : "");
+                    writeString(out, r.params[p].first);
+                    out << ": ";
+                    writeString(out, r.params[p].second);
+                }
+
+                out << "}, \"iterations\": " << r.iterations
+                    << ", \"ns\": {\"min\": " << r.time.min
+                    << ", \"median\": " << r.time.median
+                    << ", \"mean\": " << r.time.mean
+                    << ", \"stddev\": " << r.time.stddev
+                    << ", \"max\": " << r.time.max << "}";
+
+                if (r.counted)
+                    out << ", \"cycles\": " << r.cyclesPerOp << ", \"instructions\": " << r.instructionsPerOp;
+
+                out << "}" << (i + 1 < results.size() ? "," : "") << '\n';
+            }
+
+            out << "  ]\n}\n";
+        }
+    };
+} // namespace bench
+
+#endif
@@ -23,4 +23,10 @@
 // number of mesh elements
 #define MESH_SIZE 15
 
+// assemble and factorize the system matrix once per cycle, instead of in every step
+#define CACHED_SYSTEM_MATRIX true
+
+// run the ambient temperature cycles of a sweep in SIMD batches (see BatchedMesh.h)
+#define BATCHED_SWEEP false
+
 #endif
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <assert.h>
+
 namespace BLA
 {
 template <int rows, int cols = 1, class ElemT = float>
@@ -119,6 +121,32 @@ struct Sparse
     }
 };
 
+// Stores only the diagonal, kl subdiagonals and ku superdiagonals of a square matrix, row
+// by row. The entries outside of the band read as zero through a const matrix, and there is
+// nothing to write them to - the non-const access is for the band only
+template <int dim, int kl, int ku, class ElemT = float>
+struct Banded
+{
+    typedef ElemT elem_t;
+    static const int width = kl + ku + 1;
+
+    elem_t m[dim * width];
+
+    static bool inBand(int row, int col) { return col - row <= ku && row - col <= kl; }
+
+    // Unchecked access to an entry within the band
+    elem_t &band(int row, int col) { return m[row * width + col - row + kl]; }
+    elem_t band(int row, int col) const { return m[row * width + col - row + kl]; }
+
+    elem_t &operator()(int row, int col)
+    {
+        assert(inBand(row, col));
+        return band(row, col);
+    }
+
+    elem_t operator()(int row, int col) const { return inBand(row, col) ? band(row, col) : 0; }
+};
+
 template <class MemT>
 struct Trans
 {
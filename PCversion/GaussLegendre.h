@@ -0,0 +1,113 @@
+﻿#ifndef GAUSS_LEGENDRE_HEADER_GUARD
+#define GAUSS_LEGENDRE_HEADER_GUARD
+
+/*
+    Compile-time generator of Gauss-Legendre quadrature rules of any order.
+
+    The nodes are the roots of the Legendre polynomial P_n, found with Newton's method starting
+    from the usual cosine approximation, and the weights are w_i = 2 / ((1 - x_i^2) * P_n'(x_i)^2).
+    Everything is computed in long double and rounded once to the requested type.
+*/
+namespace gauss {
+    using real = long double;
+
+    constexpr real pi = 3.141592653589793238462643383279502884L;
+
+    // cosine as a Taylor series, for |x| <= pi
+    constexpr real cosSeries(real x2, real term, unsigned k) {
+        return k > 40 ? term : term + cosSeries(x2, -term * x2 / ((k + 1) * (k + 2)), k + 2);
+    }
+
+    constexpr real cos(real x) {
+        return cosSeries(x * x, 1, 0);
+    }
+
+    // P_n(x), from the three-term recurrence; `p` is P_k(x) and `pPrev` is P_k-1(x)
+    constexpr real legendreStep(unsigned n, real x, unsigned k, real pPrev, real p) {
+        return k == n ? p : legendreStep(n, x, k + 1, p, ((2*k + 1) * x * p - k * pPrev) / (k + 1));
+    }
+
+    constexpr real legendre(unsigned n, real x) {
+        return n == 0 ? 1 : legendreStep(n, x, 1, 1, x);
+    }
+
+    constexpr real legendreDerivative(unsigned n, real x) {
+        return n * (x * legendre(n, x) - legendre(n - 1, x)) / (x * x - 1);
+    }
+
+    constexpr real newtonStep(unsigned n, real x) {
+        return x - legendre(n, x) / legendreDerivative(n, x);
+    }
+
+    constexpr real refineRoot(unsigned n, real x, unsigned iterations) {
+        return iterations == 0 || newtonStep(n, x) == x
+            ? x
+            : refineRoot(n, newtonStep(n, x), iterations - 1);
+    }
+
+    // i-th root of P_n, in ascending order
+    constexpr real root(unsigned n, unsigned i) {
+        return refineRoot(n, -cos(pi * (i + 0.75L) / (n + 0.5L)), 100);
+    }
+
+    constexpr real weight(unsigned n, real x) {
+        return 2 / ((1 - x * x) * legendreDerivative(n, x) * legendreDerivative(n, x));
+    }
+
+    template<unsigned... I>
+    struct Indices {};
+
+    template<unsigned n, unsigned... I>
+    struct MakeIndices : MakeIndices<n - 1, n - 1, I...> {};
+
+    template<unsigned... I>
+    struct MakeIndices<0, I...> {
+        using type = Indices<I...>;
+    };
+
+    template<typename T>
+    struct Point {
+        T xi, weight;
+    };
+
+    template<class Rule, class Seq>
+    struct Table;
+
+    // the points of a rule as an array
+    template<class Rule, unsigned... I>
+    struct Table<Rule, Indices<I...>> {
+        constexpr static inline Point<typename Rule::value_type> points[] = {
+            { Rule::xi(I), Rule::weight(I) }...
+        };
+    };
+} // namespace gauss
+
+/*
+    Gauss-Legendre rule with `nPoints` points, with the nodes and weights of type `T`.
+    `xi` and `weight` are meant for use in constant expressions, at runtime the points are read
+    from the generated table with `point`.
+*/
+template<unsigned nPoints, typename T = float>
+struct GaussLegendre {
+    static_assert(nPoints > 0, "A quadrature rule needs at least one point");
+
+    using value_type = T;
+    using Point = gauss::Point<T>;
+    using Table = gauss::Table<GaussLegendre, typename gauss::MakeIndices<nPoints>::type>;
+
+    static constexpr unsigned size = nPoints;
+
+    static constexpr T xi(unsigned i) {
+        return T(gauss::root(nPoints, i));
+    }
+
+    static constexpr T weight(unsigned i) {
+        return T(gauss::weight(nPoints, gauss::root(nPoints, i)));
+    }
+
+    static const Point& point(unsigned i) {
+        return Table::points[i];
+    }
+};
+
+#endif
@@ -1,42 +1,79 @@
 ﻿#ifndef INTEGRATION_POINTS_H
 #define INTEGRATION_POINTS_H
 
+#include "GaussLegendre.h"
+
+/*
+    Runtime access to the Gauss schemes selectable in the config (1-4, scheme n uses n+1
+    points). The points are generated by the compiler, see GaussLegendre.h.
+*/
 class IntegrationPoints {
 public:
-    struct Point {
-        float xi, weight;
-    };
-
-private:
-    const static inline Point pts[] = {
-        // n == 1
-        { -.577350, 1.       },
-        {  .577350, 1.       },
-
-        // n == 2
-        { -.774597,  .555555 },
-        {  .0     ,  .888888 },
-        {  .774597,  .555555 },
-
-        // n == 3
-        { -.861136,  .347855 },
-        { -.339981,  .652145 },
-        {  .339981,  .652145 },
-        {  .861136,  .347855 },
-
-        // n == 4
-        { -.906180,  .236927 },
-        { -.538469,  .478629 },
-        {  .0     ,  .568889 },
-        {  .538469,  .478629 },
-        {  .906180,  .236927 },
-    };
-
+    using Point = gauss::Point<float>;
 
-public:
     static inline const Point& get(size_t n, size_t i) {
-        return pts[static_cast<size_t>(0.5*n*(n + 1) - 1) + i];
+        switch (n) {
+            case 1: return GaussLegendre<2>::point(i);
+            case 2: return GaussLegendre<3>::point(i);
+            case 3: return GaussLegendre<4>::point(i);
+            default: return GaussLegendre<5>::point(i);
+        }
+    }
+};
+
+/*
+    Gauss scheme `scheme` (uses scheme+1 points) as compile-time constants of type `T`.
+
+    Over a linear element, the radius is interpolated from the node radii rI and rJ, so every
+    integral the assembly needs is a sum over the points of the form
+        sum_j w_j * r(xi_j) * N_a(xi_j) * N_b(xi_j) = rI * massAB_I + rJ * massAB_J
+    The sums are evaluated here by the compiler, so assembling an element takes a handful of
+    multiply-adds and no loop over the integration points or reads of the point table.
+    They are accumulated in long double and rounded to `T` once.
+*/
+template<unsigned scheme, typename T = float>
+struct GaussScheme {
+    using real = gauss::real;
+    using Rule = GaussLegendre<scheme + 1, real>;
+
+    static constexpr unsigned nPoints = Rule::size;
+
+    // linear shape functions: N_0 = 0.5*(1 - xi), N_1 = 0.5*(1 + xi)
+    static constexpr real shape(unsigned k, unsigned i) {
+        return k == 0 ? 0.5L * (1 - Rule::xi(i)) : 0.5L * (1 + Rule::xi(i));
     }
+
+    // sum over the points of w * N_k * N_a * N_b
+    static constexpr real moment(unsigned k, unsigned a, unsigned b, unsigned i = 0) {
+        return i == nPoints
+            ? 0
+            : Rule::weight(i) * shape(k, i) * shape(a, i) * shape(b, i) + moment(k, a, b, i + 1);
+    }
+
+    // sum over the points of w * N_k
+    static constexpr real moment(unsigned k, unsigned i = 0) {
+        return i == nPoints ? 0 : Rule::weight(i) * shape(k, i) + moment(k, i + 1);
+    }
+
+    // capacity integrals
+    static constexpr T mass00I = T(moment(0, 0, 0));
+    static constexpr T mass01I = T(moment(0, 0, 1));
+    static constexpr T mass11I = T(moment(0, 1, 1));
+    static constexpr T mass00J = T(moment(1, 0, 0));
+    static constexpr T mass01J = T(moment(1, 0, 1));
+    static constexpr T mass11J = T(moment(1, 1, 1));
+
+    // conductivity integrals
+    static constexpr T stiffI = T(moment(0));
+    static constexpr T stiffJ = T(moment(1));
+
+    // unweighted sums of N_k over the points, for the boundary term, which is added once per point
+    static constexpr real pointSum(unsigned k, unsigned i = 0) {
+        return i == nPoints ? 0 : shape(k, i) + pointSum(k, i + 1);
+    }
+
+    static constexpr T pointSumI = T(pointSum(0));
+    static constexpr T pointSumJ = T(pointSum(1));
 };
 
 #endif
@@ -1,26 +1,138 @@
 ﻿#ifndef MESH_HEADER_GUARD
 #define MESH_HEADER_GUARD
 
+#include <cmath>
 #include "BasicLinearAlgebra.h"
 #include "Tridiagonal.h"
 #include "material.h"
 #include "IntegrationPoints.h"
+#include "MeshGrading.h"
+#include "Arena.h"
 
 #define DBG_PRINT(x)
 
-template<int nNodes>
-class Mesh {
-public:
-    struct Node {
-        float t, r;
-    };
+template<typename T = float>
+struct MeshNode {
+    T t, r;
+};
 
-    Node nodes[nNodes];
+/*
+    Assembly and time stepping shared by the fixed and runtime-sized meshes. `Bands` is
+    any storage with the `Tridiagonal` band interface, and its element type is the precision
+    everything is computed in. The nodes may store their temperatures in a different one.
+*/
+namespace fem {
+    /*
+        Assembles the system matrix `H` (capacity, conductivity and boundary terms), factorizes
+        it, and assembles the capacity matrix `C` used to form the right-hand side of each step.
+        `boundary` receives the coefficient of the ambient temperature in the last row.
+    */
+    template<unsigned scheme, class Bands, class Node, typename Real = typename Bands::elem_t>
+    void assembleWith(
+        Bands& H,
+        Bands& C,
+        Real& boundary,
+        const Node* nodes,
+        int nNodes,
+        Real dTau,
+        const MaterialT<Real>& config
+    ) {
+        using Scheme = GaussScheme<scheme, Real>;
+
+        for (int i = 0; i < nNodes; i++) {
+            H.diag(i) = 0;
+            C.diag(i) = 0;
+        }
+
+        const Real capacity = config.C * config.Ro / dTau;
+
+        for (int i = 0; i < nNodes-1; i++) {
+            Real rI = nodes[i].r;
+            Real rJ = nodes[i+1].r;
+
+            Real dR = std::abs(rI - rJ);
+
+            DBG_PRINT(dR);
+
+            Real cap = capacity * dR;
+            Real C00 = cap * (rI*Scheme::mass00I + rJ*Scheme::mass00J);
+            Real C01 = cap * (rI*Scheme::mass01I + rJ*Scheme::mass01J);
+            Real C11 = cap * (rI*Scheme::mass11I + rJ*Scheme::mass11J);
+
+            Real k = config.K / dR * (rI*Scheme::stiffI + rJ*Scheme::stiffJ);
+
+            C.diag(i) += C00;
+            C.upper(i) = C01;
+            C.lower(i) = C01;
+            C.diag(i+1) += C11;
+
+            H.diag(i) += k + C00;
+            H.upper(i) = -k + C01;
+            H.lower(i) = -k + C01;
+            H.diag(i+1) += k + C11;
+        }
+
+        // the boundary term is evaluated at the radius of each integration point of the last element
+        Real rI = nodes[nNodes-2].r;
+        Real rJ = nodes[nNodes-1].r;
+        boundary = 2*config.alphaAir * (rI*Scheme::pointSumI + rJ*Scheme::pointSumJ);
+
+        H.diag(nNodes-1) += boundary;
+        H.factorize();
+    }
 
-    void generate(float t0, float elemSize) {
+    template<class Bands, class Node, typename Real = typename Bands::elem_t>
+    using AssembleFn = void (*)(Bands&, Bands&, Real&, const Node*, int, Real, const MaterialT<Real>&);
+
+    // Picks the assembly routine for the integration scheme, so that assembly does not branch on it
+    template<class Bands, class Node>
+    AssembleFn<Bands, Node> selectAssembly(unsigned scheme) {
+        switch (scheme) {
+            case 0:
+            case 1: return &assembleWith<1, Bands, Node>;
+            case 2: return &assembleWith<2, Bands, Node>;
+            case 3: return &assembleWith<3, Bands, Node>;
+            default: return &assembleWith<4, Bands, Node>;
+        }
+    }
+
+    /*
+        Advances the node temperatures by one time step, using an already assembled system.
+        `x` is scratch space for `nNodes` values.
+    */
+    template<class Bands, class Node, typename Real = typename Bands::elem_t>
+    void integrateStep(
+        const Bands& H,
+        const Bands& C,
+        Real boundary,
+        Node* nodes,
+        Real* x,
+        int nNodes,
+        Real tAmbient
+    ) {
+        for (int i = 0; i < nNodes; i++) {
+            x[i] = C.diag(i) * nodes[i].t;
+
+            if (i > 0)
+                x[i] += C.lower(i-1) * nodes[i-1].t;
+
+            if (i < nNodes-1)
+                x[i] += C.upper(i) * nodes[i+1].t;
+        }
+
+        x[nNodes-1] += boundary * tAmbient;
+
+        H.solve(x);
+
+        for (int i = 0; i < nNodes; i++)
+            nodes[i].t = x[i];
+    }
+
+    template<class Node, typename Real>
+    void generate(Node* nodes, int nNodes, Real t0, Real elemSize) {
         // Serial << "Generating the mesh" << endl;
 
-        float r = 0;
+        Real r = 0;
         for (int i = 0; i < nNodes; i++) {
             nodes[i].t = t0;
             nodes[i].r = r;
@@ -32,71 +144,190 @@ public:
         // Serial << endl;
     }
 
-    void integrateStep(float dTau, float r, float tAmbient, const Material& config) {
-        TridiagMat<nNodes> H;
-        BLA::Matrix<nNodes> P;
+    template<class Node, typename Real>
+    void generate(Node* nodes, int nNodes, Real t0, Real rMax, MeshGrading grading, Real ratio) {
+        if (grading == MeshGrading::Uniform) {
+            generate(nodes, nNodes, t0, rMax / (nNodes - 1));
+            return;
+        }
 
-        H.Fill(0);
-        P.Fill(0);
+        for (int i = 0; i < nNodes; i++) {
+            nodes[i].t = t0;
+            nodes[i].r = gradedRadius(grading, i, nNodes - 1, rMax, ratio);
+        }
+    }
+} // namespace fem
 
-        for (int i = 0; i < nNodes-1; i++) {
-            BLA::Matrix<2,2> Hlocal;
-            BLA::Matrix<2> Plocal;
-            Hlocal.Fill(0);
-            Plocal.Fill(0);
+// `nNodes` value selecting the runtime-sized mesh
+constexpr int dynamicSize = -1;
 
-            auto& node1 = nodes[i];
-            auto& node2 = nodes[i+1];
+/*
+    `State` is the number type the node temperatures and radii are stored in, and `Compute`
+    the one the assembly and the solve are done in. Mixing them (e.g. float state with double
+    compute) halves the size of the state while keeping the round-off of the solve small.
+*/
+template<int nNodes, typename State = float, typename Compute = State>
+class Mesh {
+public:
+    using Node = MeshNode<State>;
+    using Real = Compute;
+    using Bands = Tridiagonal<nNodes, Real>;
 
-            float dR = fabs(node1.r - node2.r);
+    /*
+        Matrices of the system solved in each time step. They depend only on the node radii,
+        time step and material, so within one cycle they can be assembled just once.
+    */
+    struct System {
+        // capacity, conductivity and boundary terms, already factorized
+        TridiagMat<nNodes, Real> H;
+        // capacity terms only - multiplied by the node temperatures gives the right-hand side
+        TridiagMat<nNodes, Real> C;
+        // coefficient of the ambient temperature in the last row of the right-hand side
+        Real boundary;
+    };
 
-            DBG_PRINT(dR);
+    Node nodes[nNodes];
+    System system;
 
-            float alphaAir = (i == nNodes-2) ? config.alphaAir : 0;
+private:
+    fem::AssembleFn<Bands, Node> assembleFn = fem::selectAssembly<Bands, Node>(1);
 
-            for (unsigned j = 0; j <= config.integrationScheme; j++) {
-                const auto& intPoint = IntegrationPoints::get(config.integrationScheme, j);
+public:
+    int size() const {
+        return nNodes;
+    }
 
-                DBG_PRINT(intPoint.xi);
-                DBG_PRINT(intPoint.weight);
+    void generate(Real t0, Real elemSize) {
+        fem::generate(nodes, nNodes, t0, elemSize);
+    }
 
-                float n0 = 0.5f * (1 - intPoint.xi);
-                float n1 = 0.5f * (1 + intPoint.xi);
+    // Lays out the nodes over [0, rMax] as given by `grading` (see MeshGrading.h)
+    void generate(Real t0, Real rMax, MeshGrading grading, Real ratio) {
+        fem::generate(nodes, nNodes, t0, rMax, grading, ratio);
+    }
 
-                DBG_PRINT(n0);
-                DBG_PRINT(n1);
+    // Done once per cycle, so that the assembly itself does not branch on the scheme
+    void selectIntegrationScheme(unsigned scheme) {
+        assembleFn = fem::selectAssembly<Bands, Node>(scheme);
+    }
 
-                float r = node1.r * n0 + node2.r * n1;
-                float t = node1.t * n0 + node2.t * n1;
+    void assemble(System& sys, Real dTau, Real r, const MaterialT<Real>& config) const {
+        assembleFn(sys.H.storage, sys.C.storage, sys.boundary, nodes, nNodes, dTau, config);
+    }
 
-                DBG_PRINT(r);
-                DBG_PRINT(t);
+    void assemble(Real dTau, Real r, const MaterialT<Real>& config) {
+        assemble(system, dTau, r, config);
+    }
 
-                auto tmp = config.C * config.Ro * dR * r * intPoint.weight;
+    // Advances the node temperatures by one time step, using an already assembled system
+    void integrateStep(const System& sys, Real tAmbient) {
+        Real x[nNodes];
+        fem::integrateStep(sys.H.storage, sys.C.storage, sys.boundary, nodes, x, nNodes, tAmbient);
+    }
 
-                Hlocal(0,0) += config.K*r*intPoint.weight/dR + tmp*n0*n0/dTau;
-                Hlocal(0,1) += -config.K*r*intPoint.weight/dR + tmp*n0*n1/dTau;
-                Hlocal(1,0) = Hlocal(0,1);
-                Hlocal(1,1) += config.K*r*intPoint.weight/dR + tmp*n1*n1/dTau + 2.f*alphaAir*r;
+    void integrateStep(Real tAmbient) {
+        integrateStep(system, tAmbient);
+    }
 
-                Plocal(0) += tmp*t*n0/dTau;
-                Plocal(1) += tmp*t*n1/dTau + 2.f*alphaAir*r*tAmbient;
-            }
+    // Assembles the system from scratch and then performs the step
+    void integrateStep(Real dTau, Real r, Real tAmbient, const MaterialT<Real>& config) {
+        System sys;
+        assemble(sys, dTau, r, config);
+        integrateStep(sys, tAmbient);
+    }
+};
 
+/*
+    Mesh with the number of nodes chosen at runtime. Has the same interface as the fixed-size
+    one, but all its memory - the nodes, the cached system and the per-step scratch space -
+    comes from an `Arena`, so stepping does not allocate.
+*/
+template<typename State, typename Compute>
+class Mesh<dynamicSize, State, Compute> {
+public:
+    using Node = MeshNode<State>;
+    using Real = Compute;
+    using Bands = TridiagonalView<Real>;
 
-            P.template Submatrix<2, 1>(i, 0) += Plocal;
-            H.template Submatrix<2, 2>(i, i) += Hlocal;
-        }
+    struct System {
+        Bands H;
+        Bands C;
+        Real boundary;
+    };
 
-        // Serial << endl << "Global matrices calculated" << endl
-        //          << "H:" << endl << H << endl
-        //          << "P:" << endl << P << endl;
+private:
+    Arena& arena;
+    const int nNodes;
+    fem::AssembleFn<Bands, Node> assembleFn = fem::selectAssembly<Bands, Node>(1);
 
-        auto decomposition = BLA::LUDecompose(H);
-        auto x = BLA::LUSolve(decomposition, P);
+    Bands allocateBands() {
+        return {
+            arena.allocate<Real>(nNodes - 1),
+            arena.allocate<Real>(nNodes),
+            arena.allocate<Real>(nNodes - 1),
+            nNodes
+        };
+    }
 
-        for (int i = 0; i < nNodes; i++)
-            nodes[i].t = x(i);
+public:
+    Node* nodes;
+    System system;
+
+    Mesh(int nNodes, Arena& arena):
+        arena(arena),
+        nNodes(nNodes),
+        nodes(arena.allocate<Node>(nNodes)),
+        system(allocateSystem())
+    {}
+
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    int size() const {
+        return nNodes;
+    }
+
+    System allocateSystem() {
+        return { allocateBands(), allocateBands(), 0 };
+    }
+
+    void generate(Real t0, Real elemSize) {
+        fem::generate(nodes, nNodes, t0, elemSize);
+    }
+
+    // Lays out the nodes over [0, rMax] as given by `grading` (see MeshGrading.h)
+    void generate(Real t0, Real rMax, MeshGrading grading, Real ratio) {
+        fem::generate(nodes, nNodes, t0, rMax, grading, ratio);
+    }
+
+    // Done once per cycle, so that the assembly itself does not branch on the scheme
+    void selectIntegrationScheme(unsigned scheme) {
+        assembleFn = fem::selectAssembly<Bands, Node>(scheme);
+    }
+
+    void assemble(System& sys, Real dTau, Real r, const MaterialT<Real>& config) const {
+        assembleFn(sys.H, sys.C, sys.boundary, nodes, nNodes, dTau, config);
+    }
+
+    void assemble(Real dTau, Real r, const MaterialT<Real>& config) {
+        assemble(system, dTau, r, config);
+    }
+
+    void integrateStep(const System& sys, Real tAmbient) {
+        Arena::Scope scratch{arena};
+        Real* x = arena.allocate<Real>(nNodes);
+        fem::integrateStep(sys.H, sys.C, sys.boundary, nodes, x, nNodes, tAmbient);
+    }
+
+    void integrateStep(Real tAmbient) {
+        integrateStep(system, tAmbient);
+    }
+
+    void integrateStep(Real dTau, Real r, Real tAmbient, const MaterialT<Real>& config) {
+        Arena::Scope scratch{arena};
+        System sys = allocateSystem();
+        assemble(sys, dTau, r, config);
+        integrateStep(sys, tAmbient);
     }
 };
 
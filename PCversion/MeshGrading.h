@@ -0,0 +1,47 @@
+﻿#ifndef MESH_GRADING_HEADER_GUARD
+#define MESH_GRADING_HEADER_GUARD
+
+#include <stdint.h>
+#include <cmath>
+
+/*
+    Ways of laying out the nodes over the radius. The graded ones put more of them near the
+    surface, where the heat flows in and the temperature gradient is the steepest:
+        Uniform - elements of equal size
+        Geometric - element sizes form a geometric progression, the one at the surface
+            is `ratio` times the size of the one at the axis
+        Chebyshev - r = rMax * sin(pi/2 * i/nElements), like the spacing of Chebyshev
+            nodes near the end of the interval
+*/
+enum class MeshGrading : uint8_t {
+    Uniform,
+    Geometric,
+    Chebyshev,
+};
+
+// Radius of node `i` of a mesh of `nElements` elements over [0, rMax]
+template<typename T>
+T gradedRadius(MeshGrading grading, int i, int nElements, T rMax, T ratio) {
+    using std::pow;
+
+    switch (grading) {
+        case MeshGrading::Geometric: {
+            T q = nElements > 1 ? pow(ratio, T(1) / (nElements - 1)) : T(1);
+
+            if (std::abs(q - 1) < T(1e-6))
+                break;
+
+            return rMax * (pow(q, i) - 1) / (pow(q, nElements) - 1);
+        }
+
+        case MeshGrading::Chebyshev:
+            return rMax * std::sin(T(3.14159265358979323846L) / 2 * i / nElements);
+
+        default:
+            break;
+    }
+
+    return rMax * i / nElements;
+}
+
+#endif
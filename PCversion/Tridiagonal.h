@@ -3,6 +3,56 @@
 
 #include "BasicLinearAlgebra.h"
 
+/*
+    Factorization and solve kernels for tridiagonal systems (Thomas algorithm), working
+    directly on the band arrays. Pivoting is not done - the FEM system matrices are symmetric
+    and diagonally dominant, so it is not needed.
+*/
+namespace tridiag {
+    /*
+        Factorizes the matrix in place. Afterwards `lower[i]` holds the multiplier l(i+1, i)
+        and `diag[i]` holds the reciprocal of the i-th pivot, so the solve does not divide.
+        `upper` is left untouched. Returns false if a zero pivot was encountered.
+    */
+    template<typename T>
+    bool factorize(T* lower, T* diag, const T* upper, int n) {
+        for (int i = 0; i < n; i++) {
+            if (i > 0)
+                diag[i] -= lower[i-1] * upper[i-1];
+
+            if (diag[i] == T(0))
+                return false;
+
+            diag[i] = T(1) / diag[i];
+
+            if (i < n-1)
+                lower[i] *= diag[i];
+        }
+
+        return true;
+    }
+
+    /*
+        Solves the system factorized by `factorize`. `x` holds the right-hand side on input
+        and the solution on output. It may be of a different type than the factors, as long
+        as a factor times an `X` gives an `X`.
+    */
+    template<typename T, typename X>
+    void solve(const T* lower, const T* diag, const T* upper, X* x, int n) {
+        for (int i = 1; i < n; i++)
+            x[i] -= lower[i-1] * x[i-1];
+
+        x[n-1] = diag[n-1] * x[n-1];
+
+        for (int i = n-2; i >= 0; i--)
+            x[i] = diag[i] * (x[i] - upper[i] * x[i+1]);
+    }
+} // namespace tridiag
+
+/*
+    Storage class for `BLA::Matrix` that stores only elements on the
+    diagonal, superdiagonal and subdiagonal of the matrix. All others are reported as 0
+*/
 template<size_t dim, typename T = float>
 class Tridiagonal {
 private:
@@ -10,7 +60,7 @@ private:
     T diagonal[dim];
     T subDiagonal[dim-1];
 
-    mutable T offDiagonal = 0;
+    mutable T offDiagonal = T(0);
 
 public:
     using elem_t = T;
@@ -25,15 +75,108 @@ public:
         if (row == col+1)
             return subDiagonal[col];
 
-        return (offDiagonal = 0);
+        return (offDiagonal = T(0));
     }
 
     T& operator()(int row, int col) {
         return const_cast<T&>(static_cast<const Tridiagonal&>(*this).operator()(row, col));
     }
+
+    // Branchless access to the bands: element (i, i), (i, i+1) and (i+1, i) respectively
+    T& diag(int i) { return diagonal[i]; }
+    T& upper(int i) { return superDiagonal[i]; }
+    T& lower(int i) { return subDiagonal[i]; }
+
+    const T& diag(int i) const { return diagonal[i]; }
+    const T& upper(int i) const { return superDiagonal[i]; }
+    const T& lower(int i) const { return subDiagonal[i]; }
+
+    bool factorize() {
+        return tridiag::factorize(subDiagonal, diagonal, superDiagonal, dim);
+    }
+
+    template<typename X>
+    void solve(X* x) const {
+        tridiag::solve(subDiagonal, diagonal, superDiagonal, x, dim);
+    }
 };
 
 template<size_t dim, typename T = float>
 using TridiagMat = BLA::Matrix<dim, dim, Tridiagonal<dim, T>>;
 
+/*
+    Runtime-sized counterpart of `Tridiagonal`, with the same band interface. Does not own
+    its memory - the bands are handed in by the user, e.g. from an `Arena`.
+*/
+template<typename T = float>
+class TridiagonalView {
+private:
+    T* superDiagonal;
+    T* diagonal;
+    T* subDiagonal;
+    int dim;
+
+public:
+    using elem_t = T;
+
+    TridiagonalView(): superDiagonal(nullptr), diagonal(nullptr), subDiagonal(nullptr), dim(0) {}
+
+    TridiagonalView(T* superDiagonal, T* diagonal, T* subDiagonal, int dim):
+        superDiagonal(superDiagonal),
+        diagonal(diagonal),
+        subDiagonal(subDiagonal),
+        dim(dim)
+    {}
+
+    int size() const { return dim; }
+
+    T& diag(int i) { return diagonal[i]; }
+    T& upper(int i) { return superDiagonal[i]; }
+    T& lower(int i) { return subDiagonal[i]; }
+
+    const T& diag(int i) const { return diagonal[i]; }
+    const T& upper(int i) const { return superDiagonal[i]; }
+    const T& lower(int i) const { return subDiagonal[i]; }
+
+    bool factorize() {
+        return tridiag::factorize(subDiagonal, diagonal, superDiagonal, dim);
+    }
+
+    template<typename X>
+    void solve(X* x) const {
+        tridiag::solve(subDiagonal, diagonal, superDiagonal, x, dim);
+    }
+};
+
+/*
+    Overloads of the BLA decomposition functions, that get picked instead of the generic dense
+    ones when the matrix storage is `Tridiagonal`. They cost O(n) instead of O(n^3).
+*/
+namespace BLA {
+    template<size_t dim, typename T>
+    struct TridiagonalDecomposition {
+        bool singular;
+        // the factors overwrite the decomposed matrix, as in the dense version
+        Tridiagonal<dim, T>& factors;
+    };
+
+    template<int dim, size_t storageDim, typename T>
+    TridiagonalDecomposition<storageDim, T> LUDecompose(Matrix<dim, dim, Tridiagonal<storageDim, T>>& A) {
+        static_assert(dim == storageDim, "Matrix and storage dimensions must match");
+
+        bool singular = !A.storage.factorize();
+        return { singular, A.storage };
+    }
+
+    template<int dim, size_t storageDim, typename T, class MemT2>
+    Matrix<dim, 1, Array<dim, 1, T>> LUSolve(
+        const TridiagonalDecomposition<storageDim, T>& decomp,
+        const Matrix<dim, 1, MemT2>& b
+    ) {
+        Matrix<dim, 1, Array<dim, 1, T>> x = b;
+        decomp.factors.solve(x.storage.m);
+        return x;
+    }
+} // namespace BLA
+
 #endif
@@ -0,0 +1,196 @@
+﻿#ifndef WORK_STEALING_POOL_HEADER_GUARD
+#define WORK_STEALING_POOL_HEADER_GUARD
+
+#include <stddef.h>
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+    Runs batches of independent tasks, numbered from 0, on a fixed set of worker threads. The
+    thread calling `run` is worker 0 and takes part in the work.
+
+    Each batch is dealt out in contiguous ranges, one per worker. A worker takes the tasks from
+    the front of its own range, and when it runs out, steals the back half of the largest range
+    left to another worker - so the neighbouring tasks, which tend to cost about the same, mostly
+    stay on one worker, and the stealing only evens out the end of the batch. A range is a single
+    atomic word (begin in the high half, end in the low one), so taking and stealing are one
+    compare-and-swap each and nothing is locked while the tasks run.
+*/
+class WorkStealingPool {
+public:
+    // Called as task(worker, index), from the worker that took it
+    using Task = std::function<void(unsigned, size_t)>;
+
+private:
+    // on separate cache lines, the owner updates its range after every task
+    struct alignas(64) Range {
+        std::atomic<uint64_t> bounds{0};
+    };
+
+    static uint64_t pack(uint32_t begin, uint32_t end) {
+        return (uint64_t) begin << 32 | end;
+    }
+
+    static uint32_t beginOf(uint64_t bounds) { return bounds >> 32; }
+    static uint32_t endOf(uint64_t bounds) { return (uint32_t) bounds; }
+
+    const unsigned nWorkers;
+    std::unique_ptr<Range[]> ranges;
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const Task* task = nullptr;
+    unsigned long generation = 0;
+    unsigned nRunning = 0;
+    bool stopping = false;
+
+    // Takes the next task of the worker's own range
+    bool takeOwn(unsigned worker, size_t& index) {
+        auto& bounds = ranges[worker].bounds;
+        uint64_t current = bounds.load();
+
+        while (beginOf(current) < endOf(current)) {
+            if (bounds.compare_exchange_weak(current, pack(beginOf(current) + 1, endOf(current)))) {
+                index = beginOf(current);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // Moves the back half of the largest range of the other workers to the worker's own
+    bool steal(unsigned worker) {
+        while (true) {
+            unsigned victim = worker;
+            uint32_t largest = 0;
+
+            for (unsigned i = 0; i < nWorkers; i++) {
+                uint64_t current = ranges[i].bounds.load();
+                uint32_t size = endOf(current) - beginOf(current);
+
+                if (i != worker && beginOf(current) < endOf(current) && size > largest) {
+                    victim = i;
+                    largest = size;
+                }
+            }
+
+            if (victim == worker)
+                return false;
+
+            auto& bounds = ranges[victim].bounds;
+            uint64_t current = bounds.load();
+            uint32_t begin = beginOf(current), end = endOf(current);
+
+            if (begin >= end)
+                continue;
+
+            uint32_t middle = begin + (end - begin) / 2;
+
+            // the victim changed in the meantime, look again
+            if (!bounds.compare_exchange_strong(current, pack(begin, middle)))
+                continue;
+
+            // only the owner writes its range while it is empty
+            ranges[worker].bounds.store(pack(middle, end));
+            return true;
+        }
+    }
+
+    void work(unsigned worker, const Task& task) {
+        size_t index;
+
+        do {
+            while (takeOwn(worker, index))
+                task(worker, index);
+        } while (steal(worker));
+    }
+
+    void threadMain(unsigned worker) {
+        unsigned long seen = 0;
+
+        while (true) {
+            const Task* current;
+
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                started.wait(lock, [&] { return stopping || generation != seen; });
+
+                if (stopping)
+                    return;
+
+                seen = generation;
+                current = task;
+            }
+
+            work(worker, *current);
+
+            std::lock_guard<std::mutex> lock{mutex};
+
+            if (--nRunning == 0)
+                finished.notify_one();
+        }
+    }
+
+public:
+    // 0 workers - as many as the hardware runs at once
+    explicit WorkStealingPool(unsigned nWorkers = 0):
+        nWorkers(nWorkers > 0 ? nWorkers : std::max(1u, std::thread::hardware_concurrency())),
+        ranges(new Range[this->nWorkers])
+    {
+        for (unsigned worker = 1; worker < this->nWorkers; worker++)
+            threads.emplace_back(&WorkStealingPool::threadMain, this, worker);
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            stopping = true;
+        }
+
+        started.notify_all();
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned workers() const {
+        return nWorkers;
+    }
+
+    // Runs task(worker, i) for every i below `nTasks`, each exactly once, and waits for all of them
+    void run(size_t nTasks, const Task& task) {
+        for (unsigned worker = 0; worker < nWorkers; worker++) {
+            uint32_t begin = nTasks * worker / nWorkers;
+            uint32_t end = nTasks * (worker + 1) / nWorkers;
+            ranges[worker].bounds.store(pack(begin, end));
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            this->task = &task;
+            nRunning = nWorkers - 1;
+            generation++;
+        }
+
+        started.notify_all();
+        work(0, task);
+
+        std::unique_lock<std::mutex> lock{mutex};
+        finished.wait(lock, [&] { return nRunning == 0; });
+    }
+};
+
+#endif
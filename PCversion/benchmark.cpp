@@ -0,0 +1,254 @@
+﻿#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <string.h>
+#include <stdlib.h>
+
+#include "Benchmark.h"
+#include "BasicLinearAlgebra.h"
+#include "Mesh.h"
+#include "BatchedMesh.h"
+#include "Arena.h"
+#include "material.h"
+
+/*
+    Benchmarks of the solver: the time step with the cached system, the step that assembles
+    its system, the assembly alone, and the linear solve routines, over a range of mesh sizes,
+    integration schemes and solver variants.
+
+    Usage: benchmark [-r repetitions] [-t minTime] [-f filter] [-l label] [-o results.json]
+*/
+
+namespace {
+    constexpr float rMax = 0.005f;
+    constexpr float t0 = 20.f;
+    constexpr float tAmbient = 800.f;
+    constexpr float dTau = 0.05f;
+
+    template<typename T> const char* typeName();
+    template<> const char* typeName<float>() { return "float"; }
+    template<> const char* typeName<double>() { return "double"; }
+
+    template<class MeshT>
+    void prepare(MeshT& mesh, unsigned scheme) {
+        mesh.generate(t0, rMax / (mesh.size() - 1));
+        mesh.selectIntegrationScheme(scheme);
+    }
+
+    // The time step and the assembly of the fixed-size mesh
+    template<int nNodes, typename State, typename Compute>
+    void benchFixedMesh(bench::Runner& runner, unsigned scheme) {
+        using MeshT = Mesh<nNodes, State, Compute>;
+        const MaterialT<Compute> material{Material{}};
+
+        // the largest ones do not fit on the stack
+        auto mesh = std::make_unique<MeshT>();
+        prepare(*mesh, scheme);
+
+        bench::Params params{
+            {"storage", "fixed"}, {"nodes", std::to_string(nNodes)}, {"scheme", std::to_string(scheme)},
+            {"state", typeName<State>()}, {"compute", typeName<Compute>()}
+        };
+
+        mesh->assemble(dTau, rMax, material);
+        runner.run("integrateStep/cached", params, [&] {
+            mesh->integrateStep(tAmbient);
+            bench::doNotOptimize(mesh->nodes[0].t);
+        });
+
+        runner.run("integrateStep/uncached", params, [&] {
+            mesh->integrateStep(dTau, rMax, tAmbient, material);
+            bench::doNotOptimize(mesh->nodes[0].t);
+        });
+
+        auto sys = std::make_unique<typename MeshT::System>();
+        runner.run("assemble", params, [&] {
+            mesh->assemble(*sys, dTau, rMax, material);
+            bench::doNotOptimize(sys->boundary);
+        });
+    }
+
+    template<int nNodes, typename State, typename Compute>
+    void benchDynamicMesh(bench::Runner& runner, unsigned scheme) {
+        using MeshT = Mesh<dynamicSize, State, Compute>;
+        const MaterialT<Compute> material{Material{}};
+
+        Arena arena;
+        MeshT mesh{nNodes, arena};
+        prepare(mesh, scheme);
+
+        bench::Params params{
+            {"storage", "dynamic"}, {"nodes", std::to_string(nNodes)}, {"scheme", std::to_string(scheme)},
+            {"state", typeName<State>()}, {"compute", typeName<Compute>()}
+        };
+
+        mesh.assemble(dTau, rMax, material);
+        runner.run("integrateStep/cached", params, [&] {
+            mesh.integrateStep(tAmbient);
+            bench::doNotOptimize(mesh.nodes[0].t);
+        });
+
+        runner.run("integrateStep/uncached", params, [&] {
+            mesh.integrateStep(dTau, rMax, tAmbient, material);
+            bench::doNotOptimize(mesh.nodes[0].t);
+        });
+    }
+
+    // One batched step advances `lanes` scenarios
+    template<int nNodes>
+    void benchBatchedMesh(bench::Runner& runner, unsigned scheme) {
+        using Batch = BatchedMesh<nNodes>;
+        auto batch = std::make_unique<Batch>();
+
+        for (int l = 0; l < Batch::lanes; l++)
+            batch->setScenario(l, t0, rMax, dTau, tAmbient, Material{});
+
+        batch->generate();
+        batch->assemble(scheme);
+
+        bench::Params params{
+            {"storage", "batched"}, {"nodes", std::to_string(nNodes)}, {"scheme", std::to_string(scheme)},
+            {"lanes", std::to_string(Batch::lanes)}
+        };
+
+        runner.run("integrateStep/cached", params, [&] {
+            batch->integrateStep();
+            bench::doNotOptimize(batch->t[0][0]);
+        });
+    }
+
+    /*
+        The solve routines. The tridiagonal one uses the factorized system of the mesh, the
+        others the capacity matrix - the one matrix the assembly leaves unfactorized - stored
+        as a band and as a full matrix.
+    */
+    template<int nNodes, typename T>
+    void benchSolvers(bench::Runner& runner) {
+        using MeshT = Mesh<nNodes, T>;
+        const MaterialT<T> material{Material{}};
+
+        auto mesh = std::make_unique<MeshT>();
+        prepare(*mesh, 1);
+
+        typename MeshT::System sys;
+        mesh->assemble(sys, dTau, rMax, material);
+
+        const auto& unfactorized = sys.C.storage;
+        auto banded = std::make_unique<BLA::BandedMatrix<nNodes, 1, 1, T>>();
+
+        for (int i = 0; i < nNodes; i++)
+            for (int j = std::max(0, i - 1); j <= std::min(nNodes - 1, i + 1); j++)
+                (*banded)(i, j) = unfactorized(i, j);
+
+        bench::Params params{{"nodes", std::to_string(nNodes)}, {"type", typeName<T>()}};
+
+        T rhs[nNodes], x[nNodes];
+        for (int i = 0; i < nNodes; i++)
+            rhs[i] = T(t0);
+
+        // solves in place, so the right-hand side is copied in each time, as LUSolve does
+        runner.run("solve/tridiagonal", params, [&] {
+            std::copy(rhs, rhs + nNodes, x);
+            sys.H.storage.solve(x);
+            bench::doNotOptimize(x[0]);
+        });
+
+        auto bandedLU = BLA::LUDecompose(*banded);
+        BLA::Matrix<nNodes, 1, BLA::Array<nNodes, 1, T>> b;
+        for (int i = 0; i < nNodes; i++)
+            b(i) = T(t0);
+
+        runner.run("solve/banded", params, [&] {
+            auto y = BLA::LUSolve(bandedLU, b);
+            bench::doNotOptimize(y(0));
+        });
+
+        runner.run("factorize/tridiagonal", params, [&] {
+            Tridiagonal<nNodes, T> copy = unfactorized;
+            copy.factorize();
+            bench::doNotOptimize(copy.diag(0));
+        });
+
+        // the dense decomposition is O(n^3), so only for the small meshes
+        if constexpr (nNodes <= 51) {
+            auto dense = std::make_unique<BLA::Matrix<nNodes, nNodes, BLA::Array<nNodes, nNodes, T>>>();
+
+            for (int i = 0; i < nNodes; i++)
+                for (int j = 0; j < nNodes; j++)
+                    (*dense)(i, j) = unfactorized(i, j);
+
+            auto denseLU = BLA::LUDecompose(*dense);
+
+            runner.run("solve/dense", params, [&] {
+                auto y = BLA::LUSolve(denseLU, b);
+                bench::doNotOptimize(y(0));
+            });
+        }
+    }
+
+    template<int nNodes>
+    void benchSize(bench::Runner& runner) {
+        for (unsigned scheme = 1; scheme <= 4; scheme++)
+            benchFixedMesh<nNodes, float, float>(runner, scheme);
+
+        benchFixedMesh<nNodes, float, double>(runner, 1);
+        benchFixedMesh<nNodes, double, double>(runner, 1);
+
+        benchDynamicMesh<nNodes, float, float>(runner, 1);
+        benchDynamicMesh<nNodes, double, double>(runner, 1);
+
+        benchBatchedMesh<nNodes>(runner, 1);
+
+        benchSolvers<nNodes, float>(runner);
+        benchSolvers<nNodes, double>(runner);
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    bench::Options options;
+    const char* jsonPath = nullptr;
+
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-r") == 0)
+            options.repetitions = std::max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "-t") == 0)
+            options.minTime = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-f") == 0)
+            options.filter = argv[i + 1];
+        else if (strcmp(argv[i], "-l") == 0)
+            options.label = argv[i + 1];
+        else if (strcmp(argv[i], "-o") == 0)
+            jsonPath = argv[i + 1];
+        else {
+            std::cerr << "Usage: " << argv[0]
+                << " [-r repetitions] [-t minTime] [-f filter] [-l label] [-o results.json]\n";
+            return 1;
+        }
+    }
+
+    bench::Runner runner{options};
+
+    if (!runner.countersAvailable())
+        std::cout << "CPU counters are not available, only the times are measured\n";
+
+    bench::Runner::printHeader(std::cout, runner.countersAvailable());
+
+    benchSize<6>(runner);
+    benchSize<16>(runner);
+    benchSize<51>(runner);
+    benchSize<101>(runner);
+    benchSize<401>(runner);
+
+    if (jsonPath != nullptr) {
+        std::ofstream out{jsonPath};
+
+        if (!out) {
+            std::cerr << "Cannot open " << jsonPath << '\n';
+            return 1;
+        }
+
+        runner.writeJson(out);
+    }
+
+    return 0;
+}
@@ -189,6 +189,83 @@ Matrix<dim> LUSolve(const LUDecomposition<dim, MemT1> &decomp, const Matrix<dim,
     return x;
 }
 
+// LU decomposition of a banded matrix. It is done without pivoting, so that the factors fit
+// in the band of the matrix - that is fine for diagonally dominant matrices, like the ones of
+// FEM systems. Costs O(dim * kl * ku) and touches only the entries within the band
+template <int dim, int kl, int ku, class ElemT>
+struct BandedLUDecomposition
+{
+    bool singular;
+    // L (below the diagonal, with ones on the diagonal) and U overwrite the decomposed matrix
+    Banded<dim, kl, ku, ElemT> &factors;
+};
+
+template <int dim, int kl, int ku, class ElemT>
+BandedLUDecomposition<dim, kl, ku, ElemT> LUDecompose(Matrix<dim, dim, Banded<dim, kl, ku, ElemT>> &A)
+{
+    auto &LU = A.storage;
+
+    for (int k = 0; k < dim; ++k)
+    {
+        if (LU.band(k, k) == 0.0)
+        {
+            return {true, LU};
+        }
+
+        ElemT pivot_inv = 1.0f / LU.band(k, k);
+        int last_row = std::min(dim - 1, k + kl);
+        int last_col = std::min(dim - 1, k + ku);
+
+        for (int i = k + 1; i <= last_row; ++i)
+        {
+            ElemT multiplier = LU.band(i, k) *= pivot_inv;
+
+            for (int j = k + 1; j <= last_col; ++j)
+            {
+                LU.band(i, j) -= multiplier * LU.band(k, j);
+            }
+        }
+    }
+
+    return {false, LU};
+}
+
+template <int dim, int kl, int ku, class ElemT, class MemT2>
+Matrix<dim, 1, Array<dim, 1, ElemT>> LUSolve(const BandedLUDecomposition<dim, kl, ku, ElemT> &decomp,
+                                             const Matrix<dim, 1, MemT2> &b)
+{
+    Matrix<dim, 1, Array<dim, 1, ElemT>> x;
+    const auto &LU = decomp.factors;
+
+    // Forward substitution to solve L * y = b
+    for (int i = 0; i < dim; ++i)
+    {
+        ElemT sum = b(i);
+
+        for (int j = std::max(0, i - kl); j < i; ++j)
+        {
+            sum -= LU.band(i, j) * x(j);
+        }
+
+        x(i) = sum;
+    }
+
+    // Backward substitution to solve U * x = y
+    for (int i = dim - 1; i >= 0; --i)
+    {
+        ElemT sum = x(i);
+
+        for (int j = i + 1; j <= std::min(dim - 1, i + ku); ++j)
+        {
+            sum -= LU.band(i, j) * x(j);
+        }
+
+        x(i) = sum / LU.band(i, i);
+    }
+
+    return x;
+}
+
 template <int dim, class MemT>
 bool Invert(const Matrix<dim, dim, MemT> &A, Matrix<dim, dim, MemT> &out)
 {
@@ -1,13 +1,22 @@
 ﻿#include <iostream>
 #include <fstream>
+#include <sstream>
 #include <filesystem>
 #include <chrono>
+#include <vector>
+#include <iomanip>
+#include <algorithm>
+#include <memory>
+#include <atomic>
+#include <string.h>
 
 #include "BasicLinearAlgebra.h"
 #include "Mesh.h"
+#include "BatchedMesh.h"
+#include "Arena.h"
 #include "Config.h"
-#include "communication.h"
 #include "material.h"
+#include "WorkStealingPool.h"
 
 namespace fs = std::filesystem;
 namespace chron = std::chrono;
@@ -35,17 +44,71 @@ struct Input {
     float r = 0.005;                // [m]
     float t0 = 20;                  // [deg C]
     unsigned int nSteps = 0;
+    MeshGrading grading = MeshGrading::Uniform;
+    float gradingRatio = 1;
 };
 
-Input input;
-Material config;
-
-namespace simulation {
+/*
+    One run of the simulation: the input, the material and the time step that follows from them.
+    It holds no mesh, so any number of meshes - one per thread - can be run with it at once.
+*/
+struct Simulation {
+    Input input;
+    Material config;
     float tauEnd;
     float dTau;
-} // namespace simulation
 
-Mesh<meshconfig::nNodes> mesh;
+    explicit Simulation(const Input& input, const Material& config = {}): input(input), config(config) {
+        // założenia:
+        //    - liniowe przyspieszenie między v0 i v1
+        //    - piec jest po środku między szpulami
+        //    - prędkość nie zmienia się znacząco na długości pieca
+        float v = (input.v0 + input.v1)/2.f;
+
+        tauEnd = input.furnaceLength / v;
+
+        // float a = config.K / (config.C * config.Ro);
+
+        // dTau = (elemSize * elemSize) / (0.5 * a);
+        // nSteps = (tauEnd / dTau) + 1;
+        dTau = tauEnd / input.nSteps;
+    }
+
+    // Lays out the nodes of `mesh` at the initial temperature and assembles its system
+    template<class MeshT>
+    void setUp(MeshT& mesh) const {
+        mesh.generate(input.t0, input.r, input.grading, input.gradingRatio);
+        mesh.selectIntegrationScheme(config.integrationScheme);
+
+        #if CACHED_SYSTEM_MATRIX
+        mesh.assemble(dTau, input.r, config);
+        #endif
+    }
+
+    template<class MeshT>
+    void step(MeshT& mesh, float temp) const {
+        #if CACHED_SYSTEM_MATRIX
+        mesh.integrateStep(temp);
+        #else
+        mesh.integrateStep(dTau, input.r, temp, config);
+        #endif
+    }
+
+    template<class MeshT>
+    void resetTemperatures(MeshT& mesh) const {
+        for (int i = 0; i < mesh.size(); i++)
+            mesh.nodes[i].t = input.t0;
+    }
+};
+
+/*
+    Runtime-sized mesh of the sweep and of the element count search, all in double. The
+    capacity and conduction terms of an element cancel to about C*Ro*dR^2 / (K*dTau) of each
+    other, which float stops resolving at some thousands of elements (the system is no longer
+    diagonally dominant and the results blow up). Graded meshes also space the nodes at the
+    surface closer than float can tell apart at the radius of the wire.
+*/
+using SweepMesh = Mesh<dynamicSize, double>;
 
 float getTemp(float x, float tStart, float tEnd, float tauStart, float tauEnd) {
     if (x < tauStart)
@@ -57,85 +120,522 @@ float getTemp(float x, float tStart, float tEnd, float tauStart, float tauEnd) {
     return (tStart - tEnd)/(log(tauStart) - log(tauEnd))*log(x*exp((tEnd*log(tauStart) - tStart*log(tauEnd))/(tStart - tEnd)));
 }
 
-IterationDataPacket<meshconfig::nNodes> iterData{mesh.nodes};
+/*
+    Temperatures a cycle of `sim` at the ambient temperature `temp` can reach: between the
+    initial and the ambient one, give or take 1% of it and the round-off of 0.01 deg C. Only a
+    solver that lost its precision leaves the range.
+*/
+struct PhysicalRange {
+    float low, high;
+
+    PhysicalRange(const Simulation& sim, float temp) {
+        float margin = 0.01f * std::abs(temp - sim.input.t0) + 0.01f;
+        low = std::min(temp, sim.input.t0) - margin;
+        high = std::max(temp, sim.input.t0) + margin;
+    }
+
+    bool contains(float t) const {
+        return t >= low && t <= high;
+    }
+};
+
+/*
+    Runs `nCycles` cycles at the ambient temperatures `temps`, numbered from `firstCycle` in the
+    output. Returns the number of cycles whose core or surface temperature left their
+    PhysicalRange.
+*/
+template<class MeshT>
+int runCycles(MeshT& mesh, const Simulation& sim, std::ostream& out, const float* temps, int nCycles, int firstCycle) {
+    int nInvalid = 0;
+    sim.setUp(mesh);
+
+    for (int c = 0; c < nCycles; c++) {
+        int j = firstCycle + c;
+        float temp = temps[c];
+        PhysicalRange range{sim, temp};
+        bool valid = true;
+
+        for (unsigned step = 0; step < sim.input.nSteps; step++) {
+            auto start = chron::high_resolution_clock::now();
+            sim.step(mesh, temp);
+
+            auto duration = chron::duration_cast<chron::microseconds>(chron::high_resolution_clock::now() - start).count();
+            out << j << ','
+                << step << ','
+                << duration << ','
+                << duration << ','
+                << temp << ','
+                << mesh.nodes[0].t << ','
+                << mesh.nodes[mesh.size() - 1].t << '\n';
+
+            for (float t : { (float) mesh.nodes[0].t, (float) mesh.nodes[mesh.size() - 1].t })
+                valid = valid && range.contains(t);
+        }
+
+        if (!valid)
+            nInvalid++;
+
+        sim.resetTemperatures(mesh);
+    }
+
+    return nInvalid;
+}
+
+#if BATCHED_SWEEP
+/*
+    Runs up to `simdLanes` cycles at the ambient temperatures `temps` at once, numbered from
+    `firstCycle` in the output. The step duration written to the file is the duration of the
+    whole batched step. Returns the number of cycles that left their PhysicalRange.
+*/
+int runBatchedCycles(const Simulation& sim, std::ostream& out, const float* temps, int nCycles, int firstCycle) {
+    using Batch = BatchedMesh<meshconfig::nNodes>;
+    Batch batch;
+
+    const unsigned nSteps = sim.input.nSteps;
+    std::vector<long long> durations(nSteps);
+    std::vector<float> tempIn(nSteps * Batch::lanes);
+    std::vector<float> tempOut(nSteps * Batch::lanes);
+
+    // lanes left over in a batch that is not full just repeat the first scenario
+    for (int l = 0; l < Batch::lanes; l++)
+        batch.setScenario(l, sim.input.t0, sim.input.r, sim.dTau, temps[l < nCycles ? l : 0], sim.config);
+
+    batch.generate(sim.input.grading, sim.input.gradingRatio);
+    batch.assemble(sim.config.integrationScheme);
+
+    for (unsigned step = 0; step < nSteps; step++) {
+        auto start = chron::high_resolution_clock::now();
+        batch.integrateStep();
+        durations[step] = chron::duration_cast<chron::microseconds>(chron::high_resolution_clock::now() - start).count();
+
+        for (int l = 0; l < nCycles; l++) {
+            tempIn[step*Batch::lanes + l] = batch.t[0][l];
+            tempOut[step*Batch::lanes + l] = batch.t[meshconfig::nNodes - 1][l];
+        }
+    }
+
+    int nInvalid = 0;
+
+    for (int l = 0; l < nCycles; l++) {
+        PhysicalRange range{sim, temps[l]};
+        bool valid = true;
+
+        for (unsigned step = 0; step < nSteps; step++) {
+            float tIn = tempIn[step*Batch::lanes + l], tOut = tempOut[step*Batch::lanes + l];
+
+            out << firstCycle + l << ','
+                << step << ','
+                << durations[step] << ','
+                << durations[step] << ','
+                << temps[l] << ','
+                << tIn << ','
+                << tOut << '\n';
+
+            valid = valid && range.contains(tIn) && range.contains(tOut);
+        }
+
+        if (!valid)
+            nInvalid++;
+    }
+
+    return nInvalid;
+}
+#endif
+
+// Calls `runCycle(tAmbient)` for every ambient temperature cycle of the sweep
+template<class CycleFn>
+void forEachCycle(float tauStart, float tauEnd, float tEnd, float dTau, CycleFn runCycle) {
+    for (float tau = tauStart; tau < tauEnd; tau += dTau)
+        runCycle(getTemp(tau, 20, tEnd, tauStart, tauEnd));
+}
+
+// Ambient temperatures of all the cycles of the sweep, in order
+std::vector<float> cycleTemperatures(float tauStart, float tauEnd, float tEnd, float dTau) {
+    std::vector<float> temps;
+    forEachCycle(tauStart, tauEnd, tEnd, dTau, [&](float temp) { temps.push_back(temp); });
+    return temps;
+}
+
+struct PrecisionResult {
+    double stepsPerSecond;
+    // largest deviation from the double precision solver, over all the nodes and steps [deg C]
+    double maxDeviation;
+    // largest deviation at the end of the last cycle [deg C]
+    double finalDeviation;
+};
+
+/*
+    Runs the sweep of `sim` with the node state in `State` and the
+    assembly and solve in `Compute`. The throughput is measured on the mode alone, and the
+    deviation by running it in lockstep with a double precision mesh.
+*/
+template<typename State, typename Compute>
+PrecisionResult measurePrecision(const Simulation& sim, int nElements, float tauStart, float tauEnd, float tEnd, float dTau) {
+    Arena arena;
+    Mesh<dynamicSize, State, Compute> mesh{nElements + 1, arena};
+    Mesh<dynamicSize, double> reference{nElements + 1, arena};
+
+    sim.setUp(mesh);
+    sim.setUp(reference);
+
+    // the sweep is repeated until it took long enough to time it reliably
+    long long nStepsDone = 0;
+    double elapsed = 0;
+    auto start = chron::steady_clock::now();
+
+    while (elapsed < 0.2) {
+        forEachCycle(tauStart, tauEnd, tEnd, dTau, [&](float temp) {
+            for (unsigned step = 0; step < sim.input.nSteps; step++)
+                sim.step(mesh, temp);
+
+            sim.resetTemperatures(mesh);
+            nStepsDone += sim.input.nSteps;
+        });
+
+        elapsed = chron::duration<double>(chron::steady_clock::now() - start).count();
+    }
+
+    PrecisionResult result{ nStepsDone / elapsed, 0, 0 };
+
+    forEachCycle(tauStart, tauEnd, tEnd, dTau, [&](float temp) {
+        for (unsigned step = 0; step < sim.input.nSteps; step++) {
+            sim.step(mesh, temp);
+            sim.step(reference, temp);
+
+            result.finalDeviation = 0;
+
+            for (int i = 0; i < mesh.size(); i++) {
+                double deviation = std::abs(double(mesh.nodes[i].t) - reference.nodes[i].t);
+                result.finalDeviation = std::max(result.finalDeviation, deviation);
+            }
+
+            result.maxDeviation = std::max(result.maxDeviation, result.finalDeviation);
+        }
+
+        sim.resetTemperatures(mesh);
+        sim.resetTemperatures(reference);
+    });
+
+    return result;
+}
+
+// Prints the throughput and accuracy of every precision mode, for the sweep of `sim`
+void printPrecisionReport(const Simulation& sim, int nElements, float tauStart, float tauEnd, float tEnd, float dTau) {
+    auto printRow = [](const char* mode, const PrecisionResult& result) {
+        std::cout << std::left << std::setw(16) << mode << std::right
+            << std::setw(14) << std::fixed << std::setprecision(0) << result.stepsPerSecond
+            << std::setw(16) << std::scientific << std::setprecision(3) << result.maxDeviation
+            << std::setw(16) << result.finalDeviation << '\n';
+    };
+
+    std::cout << "nElements = " << nElements << ", nSteps = " << sim.input.nSteps << '\n'
+        << std::left << std::setw(16) << "mode" << std::right
+        << std::setw(14) << "steps/s"
+        << std::setw(16) << "max dev [C]"
+        << std::setw(16) << "final dev [C]" << '\n';
+
+    printRow("float", measurePrecision<float, float>(sim, nElements, tauStart, tauEnd, tEnd, dTau));
+    printRow("float/double", measurePrecision<float, double>(sim, nElements, tauStart, tauEnd, tEnd, dTau));
+    printRow("double", measurePrecision<double, double>(sim, nElements, tauStart, tauEnd, tEnd, dTau));
+    printRow("long double", measurePrecision<long double, long double>(sim, nElements, tauStart, tauEnd, tEnd, dTau));
+    std::cout << std::endl;
+}
+
+// Surface temperature after every step of the sweep of `sim`, on a runtime-sized mesh
+std::vector<float> surfaceTemperatures(const Simulation& sim, int nElements, float tauStart, float tauEnd, float tEnd, float dTau) {
+    Arena arena;
+    SweepMesh mesh{nElements + 1, arena};
+    std::vector<float> result;
+
+    sim.setUp(mesh);
+
+    forEachCycle(tauStart, tauEnd, tEnd, dTau, [&](float temp) {
+        for (unsigned step = 0; step < sim.input.nSteps; step++) {
+            sim.step(mesh, temp);
+            result.push_back(mesh.nodes[mesh.size() - 1].t);
+        }
+
+        sim.resetTemperatures(mesh);
+    });
+
+    return result;
+}
+
+/*
+    For each mesh grading, finds the smallest number of elements with which the surface
+    temperature stays within `tolerance` of a fine uniform mesh during the whole sweep of `input`.
+*/
+void printElementCountRecommendation(Input input, float tolerance, float tauStart, float tauEnd, float tEnd, float dTau) {
+    constexpr int nReferenceElements = 400;
+    constexpr int maxElements = 100;
+
+    struct Candidate {
+        const char* name;
+        MeshGrading grading;
+        float ratio;
+    };
+
+    const Candidate candidates[] = {
+        { "uniform",        MeshGrading::Uniform,   1.f  },
+        { "chebyshev",      MeshGrading::Chebyshev, 1.f  },
+        { "geometric:0.5",  MeshGrading::Geometric, 0.5f },
+        { "geometric:0.3",  MeshGrading::Geometric, 0.3f },
+        { "geometric:0.2",  MeshGrading::Geometric, 0.2f },
+        { "geometric:0.1",  MeshGrading::Geometric, 0.1f },
+    };
+
+    input.grading = MeshGrading::Uniform;
+    auto reference = surfaceTemperatures(Simulation{input}, nReferenceElements, tauStart, tauEnd, tEnd, dTau);
+
+    std::cout << std::defaultfloat << "nSteps = " << input.nSteps << ", tolerance = " << tolerance << " C\n"
+        << std::left << std::setw(16) << "grading" << std::right
+        << std::setw(12) << "elements"
+        << std::setw(16) << "max dev [C]" << '\n';
+
+    const Candidate* best = nullptr;
+    int bestElements = maxElements + 1;
+
+    for (const auto& candidate : candidates) {
+        input.grading = candidate.grading;
+        input.gradingRatio = candidate.ratio;
+
+        int nElements = 1;
+        double deviation = 0;
+
+        for (; nElements <= maxElements; nElements++) {
+            auto surface = surfaceTemperatures(Simulation{input}, nElements, tauStart, tauEnd, tEnd, dTau);
+            deviation = 0;
+
+            for (size_t i = 0; i < surface.size(); i++)
+                deviation = std::max(deviation, (double) std::abs(surface[i] - reference[i]));
+
+            if (deviation <= tolerance)
+                break;
+        }
+
+        std::cout << std::left << std::setw(16) << candidate.name << std::right;
+
+        if (nElements > maxElements) {
+            std::cout << std::setw(12) << "> 100" << '\n';
+            continue;
+        }
+
+        std::cout << std::setw(12) << nElements
+            << std::setw(16) << std::scientific << std::setprecision(3) << deviation << '\n';
+
+        if (nElements < bestElements) {
+            best = &candidate;
+            bestElements = nElements;
+        }
+    }
+
+    if (best != nullptr)
+        std::cout << "recommended: " << best->name << " with " << bestElements << " elements\n";
+
+    std::cout << std::endl;
+}
+
+/*
+    Runs the sweep of every simulation in `runs` on the `pool` and writes the steps of run i to
+    `outputs[i]`. The tasks are single cycles (or batches of them, with BATCHED_SWEEP), and they
+    share nothing: each sets up its own mesh - on the arena of its worker, if it is
+    runtime-sized - and writes to the buffer of its worker. The buffers are kept in memory until
+    the whole sweep is done, and then copied out in the order of the tasks, so the files do not
+    depend on the number of workers, except for the step durations. Returns the number of cycles
+    with temperatures out of the physical range (see runCycles).
+*/
+int runSweep(
+    WorkStealingPool& pool,
+    const std::vector<Simulation>& runs,
+    std::vector<std::ofstream>& outputs,
+    int nElements,
+    const std::vector<float>& temps
+) {
+    // the cycles of the runs `run`, from `firstCycle` on (counted from 0)
+    struct SweepTask {
+        size_t run;
+        int firstCycle;
+        int nCycles;
+    };
+
+    // where the output of a task is: `length` characters from `offset` in the buffer of `worker`
+    struct Segment {
+        unsigned worker;
+        size_t offset;
+        size_t length;
+    };
+
+    const bool useFixedMesh = nElements == meshconfig::nElements;
+    int cyclesPerTask = 1;
+
+    #if BATCHED_SWEEP
+    if (useFixedMesh)
+        cyclesPerTask = BatchedMesh<meshconfig::nNodes>::lanes;
+    #endif
+
+    std::vector<SweepTask> tasks;
+
+    for (size_t run = 0; run < runs.size(); run++) {
+        for (int first = 0; first < (int) temps.size(); first += cyclesPerTask)
+            tasks.push_back({ run, first, std::min(cyclesPerTask, (int) temps.size() - first) });
+    }
+
+    std::vector<std::ostringstream> buffers(pool.workers());
+    std::unique_ptr<Arena[]> arenas{new Arena[pool.workers()]};
+    std::vector<Segment> segments(tasks.size());
+    std::atomic<int> nInvalid{0};
+
+    pool.run(tasks.size(), [&](unsigned worker, size_t i) {
+        const SweepTask& task = tasks[i];
+        const Simulation& sim = runs[task.run];
+        const float* cycleTemps = &temps[task.firstCycle];
+        std::ostringstream& out = buffers[worker];
+        size_t offset = out.tellp();
+
+        if (useFixedMesh) {
+            #if BATCHED_SWEEP
+            nInvalid += runBatchedCycles(sim, out, cycleTemps, task.nCycles, task.firstCycle + 1);
+            #else
+            Mesh<meshconfig::nNodes> mesh;
+            nInvalid += runCycles(mesh, sim, out, cycleTemps, task.nCycles, task.firstCycle + 1);
+            #endif
+        } else {
+            Arena::Scope scope{arenas[worker]};
+            SweepMesh mesh{nElements + 1, arenas[worker]};
+            nInvalid += runCycles(mesh, sim, out, cycleTemps, task.nCycles, task.firstCycle + 1);
+        }
+
+        segments[i] = { worker, offset, (size_t) out.tellp() - offset };
+    });
+
+    std::vector<std::string> contents;
+
+    for (auto& buffer : buffers)
+        contents.push_back(buffer.str());
 
-void calculateSimulationParams() {
-    using namespace simulation;
-    // założenia:
-    //    - liniowe przyspieszenie między v0 i v1
-    //    - piec jest po środku między szpulami
-    //    - prędkość nie zmienia się znacząco na długości pieca
-    float v = (input.v0 + input.v1)/2.f;
+    for (size_t i = 0; i < tasks.size(); i++) {
+        const Segment& segment = segments[i];
+        outputs[tasks[i].run].write(contents[segment.worker].data() + segment.offset, segment.length);
+    }
 
-    tauEnd = input.furnaceLength / v;
+    return nInvalid;
+}
 
-    // float a = config.K / (config.C * config.Ro);
-    float elemSize = input.r / meshconfig::nElements;
+// Parses "uniform", "chebyshev" or "geometric:ratio"
+bool parseGrading(const char* arg, Input& input) {
+    if (strcmp(arg, "uniform") == 0) {
+        input.grading = MeshGrading::Uniform;
+        return true;
+    }
 
-    // dTau = (elemSize * elemSize) / (0.5 * a);
-    // nSteps = (tauEnd / dTau) + 1;
-    dTau = tauEnd / input.nSteps;
+    if (strcmp(arg, "chebyshev") == 0) {
+        input.grading = MeshGrading::Chebyshev;
+        return true;
+    }
 
-    iterData.nSteps = input.nSteps;
-    iterData.step = 0;
-    iterData.tau = 0.f;
+    if (strncmp(arg, "geometric:", 10) == 0) {
+        input.grading = MeshGrading::Geometric;
+        input.gradingRatio = atof(arg + 10);
+        return input.gradingRatio > 0;
+    }
 
-    mesh.generate(input.t0, elemSize);
+    return false;
 }
 
+/*
+    Usage: PCproject [-e nElements] [-g grading] [-j nThreads] outputPattern nSteps...
+           PCproject [-e nElements] [-g grading] -p nSteps...
+           PCproject -n tolerance nSteps...
+
+    Runs the simulation once for every `nSteps` value and writes the results to a file named
+    by formatting `outputPattern` with it. `-e` sets the number of mesh elements - if it differs
+    from `meshconfig::nElements`, the runtime-sized mesh is used. `-g` sets how the nodes are
+    laid out: uniform (default), chebyshev or geometric:ratio (see MeshGrading.h). The cycles of
+    all the runs are spread over `-j` threads, by default as many as the hardware runs at once
+    (see runSweep).
+
+    With `-p`, runs the simulation in every precision mode instead (float, float state with
+    double computation, double and long double) and prints their throughput and deviation
+    from the double precision results.
+
+    With `-n`, prints the smallest number of elements for each grading, with which the surface
+    temperature stays within `tolerance` [deg C] of a fine uniform mesh.
+*/
 int main(int argc, char* argv[]) {
-    if (argc < 3)
+    int firstArg = 1;
+    int nElements = meshconfig::nElements;
+    int nThreads = 0;
+    Input input;
+
+    for (; firstArg + 1 < argc; firstArg += 2) {
+        if (strcmp(argv[firstArg], "-e") == 0)
+            nElements = atoi(argv[firstArg + 1]);
+        else if (strcmp(argv[firstArg], "-j") == 0)
+            nThreads = atoi(argv[firstArg + 1]);
+        else if (strcmp(argv[firstArg], "-g") == 0) {
+            if (!parseGrading(argv[firstArg + 1], input)) {
+                std::cerr << "Invalid value of -g: " << argv[firstArg + 1] << '\n';
+                return -1;
+            }
+        }
+        else
+            break;
+    }
+
+    if (argc < firstArg + 2 || nElements < 1 || nThreads < 0)
         return -1;
 
     float tauStart = 0.0001;
     float tauEnd = 10;
     float tEnd = 800.f;
-    float tau = tauStart;
     float dTau = 0.5;
 
-    for (int i = 2; i < argc; i++) {
-        char filename[400] = { 0 };
+    if (strcmp(argv[firstArg], "-n") == 0) {
+        float tolerance = atof(argv[firstArg + 1]);
 
-        input.nSteps = atoi(argv[i]);
-        snprintf(filename, 400, argv[1], input.nSteps);
-        calculateSimulationParams();
+        for (int i = firstArg + 2; i < argc; i++) {
+            input.nSteps = atoi(argv[i]);
+            printElementCountRecommendation(input, tolerance, tauStart, tauEnd, tEnd, dTau);
+        }
 
-        fs::path path{filename};
+        return 0;
+    }
 
-        if (!fs::exists(path.parent_path()))
-            fs::create_directories(path.parent_path());
+    if (strcmp(argv[firstArg], "-p") == 0) {
+        for (int i = firstArg + 1; i < argc; i++) {
+            input.nSteps = atoi(argv[i]);
+            printPrecisionReport(Simulation{input}, nElements, tauStart, tauEnd, tEnd, dTau);
+        }
 
-        std::ofstream out{path};
+        return 0;
+    }
 
-        out << "cycle, iteration, arduinoDurationMicros, pcDuration, tempAmb, tempIn, tempOut\n";
+    std::vector<Simulation> runs;
+    std::vector<std::ofstream> outputs;
 
-        tau = tauStart;
-        for (int j = 1; tau < tauEnd; tau += dTau, j++) {
-            float temp = getTemp(tau, 20, tEnd, tauStart, tauEnd);
+    for (int i = firstArg + 1; i < argc; i++) {
+        char filename[400] = { 0 };
+
+        input.nSteps = atoi(argv[i]);
+        snprintf(filename, 400, argv[firstArg], input.nSteps);
 
-            while (iterData.step < input.nSteps) {
-                auto start = chron::high_resolution_clock::now();
-                mesh.integrateStep(simulation::dTau, input.r, temp, config);
+        fs::path path{filename};
 
-                auto duration = chron::duration_cast<chron::microseconds>(chron::high_resolution_clock::now() - start).count();
-                out << j << ','
-                    << iterData.step << ','
-                    << duration << ','
-                    << duration << ','
-                    << temp << ','
-                    << mesh.nodes[0].t << ','
-                    << mesh.nodes[meshconfig::nNodes - 1].t << '\n';
+        if (!fs::exists(path.parent_path()))
+            fs::create_directories(path.parent_path());
 
-                iterData.step++;
-                iterData.tau += simulation::dTau;
-            }
+        runs.emplace_back(input);
+        outputs.emplace_back(path);
+        outputs.back() << "cycle, iteration, arduinoDurationMicros, pcDuration, tempAmb, tempIn, tempOut\n";
+    }
 
-            iterData.step = 0;
-            iterData.tau = 0.f;
+    WorkStealingPool pool{(unsigned) nThreads};
+    int nInvalid = runSweep(pool, runs, outputs, nElements, cycleTemperatures(tauStart, tauEnd, tEnd, dTau));
 
-            for (auto& node : mesh.nodes)
-                node.t = input.t0;
-        }
+    if (nInvalid > 0) {
+        std::cerr << nInvalid << " cycles left the range between the initial and the ambient temperature, "
+            "the solver lost its precision\n";
+        return -1;
     }
 
     return 0;
@@ -1,12 +1,27 @@
 #ifndef MATERIAL_HEADER_GUARD
 #define MATERIAL_HEADER_GUARD
 
-struct Material {
+template<typename T>
+struct MaterialT {
     unsigned integrationScheme = 1;
-    float alphaAir = 300;   // [W/(m^2*K)]
-    float C = 700.0;        // [J/(kg*K)]
-    float Ro = 7800.0;      // [kg/m^3]
-    float K = 25.0;         // [W/m*K]
+    T alphaAir = 300;   // [W/(m^2*K)]
+    T C = 700.0;        // [J/(kg*K)]
+    T Ro = 7800.0;      // [kg/m^3]
+    T K = 25.0;         // [W/m*K]
+
+    MaterialT() = default;
+
+    // lets a solver computing in another precision take the material as is
+    template<typename U>
+    MaterialT(const MaterialT<U>& other):
+        integrationScheme(other.integrationScheme),
+        alphaAir(other.alphaAir),
+        C(other.C),
+        Ro(other.Ro),
+        K(other.K)
+    {}
 };
 
+using Material = MaterialT<float>;
+
 #endif
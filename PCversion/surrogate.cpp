@@ -0,0 +1,308 @@
+﻿#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+#include <string.h>
+#include <stdlib.h>
+
+#include "BasicLinearAlgebra.h"
+#include "Mesh.h"
+#include "Arena.h"
+#include "material.h"
+#include "IntegrationPoints.h"
+
+/*
+    Generates the surrogate table of the sketch (see Surrogate.h in the main directory): the
+    core and surface temperatures at the end of the furnace, over a grid of the time spent in
+    it, tau = furnaceLength / ((v0 + v1)/2), and of the wire radius. The times are spaced
+    evenly and the radii geometrically - that keeps the interpolation error about 20 times
+    smaller than even spacing would, with the same number of points.
+
+    With constant material properties the temperatures are linear in the furnace and initial
+    ones, so the table holds the response f = (t - t0) / (tFurnace - t0), which is the same for
+    all of them - the furnace temperature needs no axis. The rest of the parameters (the
+    material, mesh and integration scheme) are fixed, and written to the table, so the sketch
+    can tell when it does not apply.
+
+    The cycles are run with `nSteps` backward Euler steps. The table also gets two error bounds
+    of the response: of the interpolation, from the solver run at the midpoints of the cells and
+    their edges, and of the time steps, as the change from running half as many of them.
+
+    Usage: surrogate [-e nElements] [-s nSteps] [-g grading] [-t tauMin:tauMax:n]
+                     [-r rMin:rMax:n] output.h
+*/
+
+namespace {
+    // `size` points from `min` to `max`, spaced evenly, or in a geometric progression
+    struct Axis {
+        float min, max;
+        int size;
+        bool geometric;
+
+        float at(float i) const {
+            float x = i / (size - 1);
+            return geometric ? min * std::pow(max / min, x) : min + (max - min) * x;
+        }
+    };
+
+    struct Options {
+        int nElements = 10;
+        unsigned nSteps = 1000;
+        MeshGrading grading = MeshGrading::Uniform;
+        float gradingRatio = 1;
+        Axis tau{ 0.05f, 2.f, 32, false };      // [s]
+        // the response changes the fastest with the radius for thin wires
+        Axis r{ 0.0005f, 0.005f, 16, true };    // [m]
+    };
+
+    struct Response {
+        double core, surface;
+    };
+
+    Options options;
+    Material material;
+
+    template<unsigned scheme>
+    double boundaryScaleWith(double rI, double rJ) {
+        using Scheme = GaussScheme<scheme>;
+        return Scheme::nPoints * rJ / (rI*Scheme::pointSumI + rJ*Scheme::pointSumJ);
+    }
+
+    /*
+        The sketch adds the boundary term once per integration point at the surface radius,
+        where the PC mesh takes the radius of each point. Scaling alphaAir by the ratio of the
+        two makes the table match the sketch.
+    */
+    double boundaryScale(unsigned scheme, double rI, double rJ) {
+        switch (scheme) {
+            case 0:
+            case 1: return boundaryScaleWith<1>(rI, rJ);
+            case 2: return boundaryScaleWith<2>(rI, rJ);
+            case 3: return boundaryScaleWith<3>(rI, rJ);
+            default: return boundaryScaleWith<4>(rI, rJ);
+        }
+    }
+
+    // Response at the end of a cycle of length `tau` [s], of a wire of radius `r` [m]
+    Response simulate(float tau, float r, unsigned nSteps) {
+        Arena arena;
+        Mesh<dynamicSize, double> mesh{options.nElements + 1, arena};
+
+        mesh.generate(0, r, options.grading, options.gradingRatio);
+        mesh.selectIntegrationScheme(material.integrationScheme);
+
+        int last = mesh.size() - 1;
+        Material sketch = material;
+        sketch.alphaAir *= boundaryScale(material.integrationScheme, mesh.nodes[last - 1].r, mesh.nodes[last].r);
+
+        mesh.assemble(tau / nSteps, r, sketch);
+
+        for (unsigned step = 0; step < nSteps; step++)
+            mesh.integrateStep(1);
+
+        return { mesh.nodes[0].t, mesh.nodes[mesh.size() - 1].t };
+    }
+
+    struct Table {
+        std::vector<Response> values;
+        double interpolationError = 0;
+        double timeStepError = 0;
+
+        const Response& at(int iR, int iTau) const {
+            return values[iR * options.tau.size + iTau];
+        }
+
+        // Bilinear interpolation at the fractional grid position
+        Response interpolate(float iR, float iTau) const {
+            int r0 = std::min((int) iR, options.r.size - 2);
+            int t0 = std::min((int) iTau, options.tau.size - 2);
+            double fr = iR - r0, ft = iTau - t0;
+
+            auto mix = [&](double Response::* field) {
+                double low = at(r0, t0).*field * (1 - ft) + at(r0, t0 + 1).*field * ft;
+                double high = at(r0 + 1, t0).*field * (1 - ft) + at(r0 + 1, t0 + 1).*field * ft;
+                return low * (1 - fr) + high * fr;
+            };
+
+            return { mix(&Response::core), mix(&Response::surface) };
+        }
+    };
+
+    Table generate() {
+        Table table;
+
+        for (int i = 0; i < options.r.size; i++) {
+            for (int j = 0; j < options.tau.size; j++) {
+                float tau = options.tau.at(j), r = options.r.at(i);
+                Response full = simulate(tau, r, options.nSteps);
+                Response half = simulate(tau, r, options.nSteps / 2);
+
+                table.values.push_back(full);
+                table.timeStepError = std::max({
+                    table.timeStepError,
+                    std::abs(full.core - half.core),
+                    std::abs(full.surface - half.surface)
+                });
+            }
+        }
+
+        // the interpolation error is the largest in the middle of the cells, or of their edges
+        for (int i = 0; i < 2*options.r.size - 1; i++) {
+            for (int j = 0; j < 2*options.tau.size - 1; j++) {
+                if (i % 2 == 0 && j % 2 == 0)
+                    continue;
+
+                float iR = i / 2.f, iTau = j / 2.f;
+                Response exact = simulate(options.tau.at(iTau), options.r.at(iR), options.nSteps);
+                Response interpolated = table.interpolate(iR, iTau);
+
+                table.interpolationError = std::max({
+                    table.interpolationError,
+                    std::abs(exact.core - interpolated.core),
+                    std::abs(exact.surface - interpolated.surface)
+                });
+            }
+        }
+
+        return table;
+    }
+
+    // the response, 0 to 1, in 1/65535
+    unsigned quantize(double f) {
+        return (unsigned) std::lround(std::clamp(f, 0.0, 1.0) * 65535);
+    }
+
+    void writeArray(std::ostream& out, const char* name, const Table& table, double Response::* field) {
+        out << "        const uint16_t " << name << "[nR][nTau] PROGMEM = {\n";
+
+        for (int i = 0; i < options.r.size; i++) {
+            out << "            {";
+
+            for (int j = 0; j < options.tau.size; j++)
+                out << (j % 12 == 0 ? "\n                " : " ") << quantize(table.at(i, j).*field) << ',';
+
+            out << "\n            },\n";
+        }
+
+        out << "        };\n";
+    }
+
+    void write(std::ostream& out, const Table& table) {
+        // the quantization adds half of its step to the interpolation error
+        double quantization = 0.5 / 65535;
+
+        out << std::setprecision(7)
+            << "#ifndef SURROGATE_TABLE_HEADER_GUARD\n"
+            << "#define SURROGATE_TABLE_HEADER_GUARD\n\n"
+            << "/* Generated by PCversion/surrogate, see Surrogate.h */\n\n"
+            << "namespace surrogate {\n"
+            << "    namespace table {\n"
+            << "        // parameters the table was generated with\n"
+            << "        constexpr int nElements = " << options.nElements << ";\n"
+            << "        constexpr unsigned meshGrading = " << (unsigned) options.grading << ";\n"
+            << "        constexpr float gradingRatio = " << options.gradingRatio << ";\n"
+            << "        constexpr unsigned integrationScheme = " << material.integrationScheme << ";\n"
+            << "        constexpr float alphaAir = " << material.alphaAir << ";\n"
+            << "        constexpr float C = " << material.C << ";\n"
+            << "        constexpr float Ro = " << material.Ro << ";\n"
+            << "        constexpr float K = " << material.K << ";\n\n"
+            << "        // time in the furnace [s]\n"
+            << "        constexpr float tauMin = " << options.tau.min << ";\n"
+            << "        constexpr float tauMax = " << options.tau.max << ";\n"
+            << "        constexpr uint8_t nTau = " << options.tau.size << ";\n\n"
+            << "        // wire radius [m], in a geometric progression\n"
+            << "        constexpr float rMin = " << options.r.min << ";\n"
+            << "        constexpr float rMax = " << options.r.max << ";\n"
+            << "        constexpr uint8_t nR = " << options.r.size << ";\n\n"
+            << "        // largest errors of the response, of the interpolation and of the " << options.nSteps << " time steps,\n"
+            << "        // from the converged solution - the steps of the sketch add their own\n"
+            << "        constexpr float interpolationError = " << table.interpolationError + quantization << ";\n"
+            << "        constexpr float timeStepError = " << table.timeStepError << ";\n\n"
+            << "        // (t - t0) / (tFurnace - t0) at the end of the furnace, in 1/65535\n";
+
+        writeArray(out, "core", table, &Response::core);
+        out << '\n';
+        writeArray(out, "surface", table, &Response::surface);
+
+        out << "    } // namespace table\n"
+            << "} // namespace surrogate\n\n"
+            << "#endif\n";
+    }
+
+    // Parses "min:max:n"
+    bool parseAxis(const char* arg, Axis& axis) {
+        return sscanf(arg, "%f:%f:%d", &axis.min, &axis.max, &axis.size) == 3
+            && axis.min < axis.max && axis.size >= 2 && axis.size <= 255
+            && (!axis.geometric || axis.min > 0);
+    }
+
+    // Parses "uniform", "chebyshev" or "geometric:ratio"
+    bool parseGrading(const char* arg) {
+        if (strcmp(arg, "uniform") == 0) {
+            options.grading = MeshGrading::Uniform;
+            return true;
+        }
+
+        if (strcmp(arg, "chebyshev") == 0) {
+            options.grading = MeshGrading::Chebyshev;
+            return true;
+        }
+
+        if (strncmp(arg, "geometric:", 10) == 0) {
+            options.grading = MeshGrading::Geometric;
+            options.gradingRatio = atof(arg + 10);
+            return options.gradingRatio > 0;
+        }
+
+        return false;
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int arg = 1;
+
+    for (; arg + 1 < argc; arg += 2) {
+        bool valid = true;
+
+        if (strcmp(argv[arg], "-e") == 0)
+            valid = (options.nElements = atoi(argv[arg + 1])) > 0;
+        else if (strcmp(argv[arg], "-s") == 0)
+            valid = (options.nSteps = atoi(argv[arg + 1])) >= 2;
+        else if (strcmp(argv[arg], "-g") == 0)
+            valid = parseGrading(argv[arg + 1]);
+        else if (strcmp(argv[arg], "-t") == 0)
+            valid = parseAxis(argv[arg + 1], options.tau);
+        else if (strcmp(argv[arg], "-r") == 0)
+            valid = parseAxis(argv[arg + 1], options.r);
+        else
+            break;
+
+        if (!valid) {
+            std::cerr << "Invalid value of " << argv[arg] << ": " << argv[arg + 1] << '\n';
+            return -1;
+        }
+    }
+
+    if (arg + 1 != argc) {
+        std::cerr << "Usage: surrogate [-e nElements] [-s nSteps] [-g grading] [-t tauMin:tauMax:n] "
+            "[-r rMin:rMax:n] output.h\n";
+        return -1;
+    }
+
+    Table table = generate();
+    std::ofstream out{argv[arg]};
+
+    if (!out) {
+        std::cerr << "Cannot write " << argv[arg] << '\n';
+        return -1;
+    }
+
+    write(out, table);
+
+    std::cout << "interpolation error " << table.interpolationError
+        << ", time step error " << table.timeStepError << " (of the response)\n";
+
+    return 0;
+}
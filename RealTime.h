@@ -0,0 +1,124 @@
+#ifndef REAL_TIME_HEADER_GUARD
+#define REAL_TIME_HEADER_GUARD
+
+/*
+    Steps of the real time mode that make a cycle cheaper, taken one at a time while the
+    simulation cannot keep up. From FewerSteps on, every level halves the number of steps (or
+    doubles the tolerance of the adaptive step) once more.
+*/
+enum class Degradation : uint8_t {
+    None,
+    // the steps are not sent, only the start and the end of the cycle
+    NoTelemetry,
+    // backward Euler and a one-point integration rule
+    CheaperScheme,
+    FewerSteps
+};
+
+/*
+    Paces the steps of a cycle by the wall clock, so that the simulated time follows the time
+    the wire spends in the furnace. The step ending at the simulated time `tau` is released
+    when that much time has passed since the start of the cycle - so its furnace temperature
+    has already been measured - and should finish before the next one is released, that is
+    within its own length. A step that finishes later is a deadline miss, and the steps after
+    it run one after another, until the simulation catches up.
+
+    At the end of the cycle the level of degradation goes up if there were any misses, and down
+    if no step took more than `relaxLoad` of its length, which leaves room for the steps getting
+    twice as expensive.
+*/
+class RealTimePacer {
+    static constexpr uint8_t maxLevel = (uint8_t) Degradation::FewerSteps + 4;
+    static constexpr float relaxLoad = 0.4f;
+
+    unsigned long cycleStart = 0;   // [us]
+    uint8_t currentLevel = 0;
+
+    unsigned cycleMisses = 0;
+    float worstLoad = 0;
+
+    unsigned long nMisses = 0;
+    // delay of the end of the last cycle after its wall clock end, and the largest one [us]
+    unsigned long lastLag = 0;
+    unsigned long maxLag = 0;
+
+    unsigned long wallTime(float tau) const {
+        return cycleStart + (unsigned long) (tau * 1e6f);
+    }
+
+public:
+    void startCycle(unsigned long now) {
+        cycleStart = now;
+        cycleMisses = 0;
+        worstLoad = 0;
+    }
+
+    // Whether the step ending at the simulated time `tau` [s] may run
+    bool due(float tau, unsigned long now) const {
+        return (long) (now - wallTime(tau)) >= 0;
+    }
+
+    /*
+        Records the step from `tauFrom` to `tauTo` [s], run from `begin` to `end` [us]. The
+        deadline is the release time of the next step, if it is just as long.
+    */
+    void stepDone(float tauFrom, float tauTo, unsigned long begin, unsigned long end) {
+        float length = (tauTo - tauFrom) * 1e6f;
+        unsigned long deadline = wallTime(tauTo) + (unsigned long) length;
+
+        if ((long) (end - deadline) > 0) {
+            cycleMisses++;
+            nMisses++;
+        }
+
+        float load = (end - begin) / length;
+
+        if (load > worstLoad)
+            worstLoad = load;
+    }
+
+    /*
+        Ends the cycle, whose last step ended at the simulated time `tau` and finished at `end`
+        [us], and adjusts the level of degradation. Returns whether it changed - the next cycle
+        has to be set up again.
+    */
+    bool endCycle(float tau, unsigned long end) {
+        long lag = end - wallTime(tau);
+        lastLag = lag > 0 ? lag : 0;
+
+        if (lastLag > maxLag)
+            maxLag = lastLag;
+
+        if (cycleMisses > 0 && currentLevel < maxLevel) {
+            currentLevel++;
+            return true;
+        }
+
+        if (cycleMisses == 0 && worstLoad < relaxLoad && currentLevel > 0) {
+            currentLevel--;
+            return true;
+        }
+
+        return false;
+    }
+
+    uint8_t level() const { return currentLevel; }
+
+    bool degraded(Degradation d) const { return currentLevel >= (uint8_t) d; }
+
+    // how many times the number of steps is halved
+    uint8_t halvings() const {
+        return degraded(Degradation::FewerSteps)
+            ? currentLevel - (uint8_t) Degradation::FewerSteps + 1
+            : 0;
+    }
+
+    unsigned long misses() const { return nMisses; }
+
+    // how late the result of the last cycle was [us]
+    unsigned long cycleLag() const { return lastLag; }
+
+    unsigned long worstLag() const { return maxLag; }
+};
+
+#endif
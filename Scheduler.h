@@ -0,0 +1,95 @@
+#ifndef SCHEDULER_HEADER_GUARD
+#define SCHEDULER_HEADER_GUARD
+
+#include <Print.h>
+#include <print_util.h>
+
+using namespace prnt;
+
+/*
+    A periodic task of the Scheduler. `period` is the time between its due times [ms], a task
+    with period 0 is due again as soon as it finishes, so it runs on every pass. A run that
+    starts more than `deadline` [ms] after the due time counts as late (0 - no deadline).
+*/
+struct Task {
+    using Fn = void (*)();
+
+    const char* name;
+    Fn run;
+    uint16_t period;
+    uint16_t deadline;
+
+    unsigned long due = 0;              // [us]
+    // largest delay from the due time to the start, and the longest run [us]
+    unsigned long worstLatency = 0;
+    unsigned long worstDuration = 0;
+    unsigned late = 0;
+};
+
+/*
+    Cooperative scheduler: on every pass runs each task that is due, in the order of the table.
+    Nothing is preempted, so a long task delays all the others - which is what the latency of
+    each task shows. A task that falls behind by more than its period is not run repeatedly to
+    catch up, its next due time is counted from the end of the late run.
+*/
+template<uint8_t nTasks>
+class Scheduler {
+    Task (&tasks)[nTasks];
+
+public:
+    explicit Scheduler(Task (&tasks)[nTasks]): tasks(tasks) {}
+
+    // Makes all the tasks due now
+    void start() {
+        unsigned long now = micros();
+
+        for (auto& task : tasks)
+            task.due = now;
+    }
+
+    void runOnce() {
+        for (auto& task : tasks) {
+            unsigned long begin = micros();
+
+            if ((long) (begin - task.due) < 0)
+                continue;
+
+            unsigned long latency = begin - task.due;
+
+            task.run();
+
+            unsigned long end = micros();
+
+            if (latency > task.worstLatency)
+                task.worstLatency = latency;
+
+            if (end - begin > task.worstDuration)
+                task.worstDuration = end - begin;
+
+            if (task.deadline > 0 && latency > task.deadline * 1000UL)
+                task.late++;
+
+            task.due += task.period * 1000UL;
+
+            if ((long) (end - task.due) > 0)
+                task.due = end;
+        }
+    }
+
+    void resetStats() {
+        for (auto& task : tasks) {
+            task.worstLatency = 0;
+            task.worstDuration = 0;
+            task.late = 0;
+        }
+    }
+
+    void report(Print& out) const {
+        for (const auto& task : tasks) {
+            out << task.name << ": worst latency " << task.worstLatency << " us, worst run "
+                << task.worstDuration << " us, late " << task.late << endl;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef SURROGATE_HEADER_GUARD
+#define SURROGATE_HEADER_GUARD
+
+#include "MeshGrading.h"
+#include "SurrogateTable.h"
+
+/*
+    Core and surface temperatures at the end of the furnace, looked up in a table instead of
+    simulating the cycle. The table (SurrogateTable.h) is generated on the PC by
+    PCversion/surrogate, for one material, mesh and integration rule, over the time spent in the
+    furnace and the wire radius. It holds the response f = (t - t0) / (tFurnace - t0), which does
+    not depend on the temperatures as long as the material properties are constant, and is
+    interpolated bilinearly - in the time, and in the logarithm of the radius.
+
+    The result assumes a constant furnace temperature over the cycle. Outside of the table, or
+    with other parameters, `covers` is false and the cycle has to be simulated.
+
+    The table is made with many more time steps than the sketch takes, so its error bound is the
+    one from the converged solution. A cycle simulated by the sketch, with its own number of
+    steps, is off from the same solution by its time step error on top of that.
+*/
+namespace surrogate {
+    struct Result {
+        float core, surface;    // [deg C]
+        // bound of the difference from the converged solution, with the time steps of the
+        // table [deg C] - not from the cycle the sketch would simulate
+        float error;
+    };
+
+    namespace detail {
+        inline bool near(float value, float expected) {
+            return fabs(value - expected) <= 1e-4f * fabs(expected);
+        }
+
+        // fractional index of `x` on the axis from `min` to `max` with `size` points
+        inline float position(float x, float min, float max, uint8_t size) {
+            return (x - min) / (max - min) * (size - 1);
+        }
+
+        inline float lookup(const uint16_t (&values)[table::nR][table::nTau], float iR, float iTau) {
+            uint8_t r0 = min((uint8_t) iR, (uint8_t) (table::nR - 2));
+            uint8_t t0 = min((uint8_t) iTau, (uint8_t) (table::nTau - 2));
+            float fr = iR - r0, ft = iTau - t0;
+
+            float low = pgm_read_word(&values[r0][t0]) * (1 - ft)
+                + pgm_read_word(&values[r0][t0 + 1]) * ft;
+            float high = pgm_read_word(&values[r0 + 1][t0]) * (1 - ft)
+                + pgm_read_word(&values[r0 + 1][t0 + 1]) * ft;
+
+            return (low * (1 - fr) + high * fr) / 65535.f;
+        }
+    } // namespace detail
+
+    // Whether the table holds the cycle of length `tau` [s] of a mesh of `nElements` with `input`
+    template<typename InputT>
+    bool covers(const InputT& input, float tau, int nElements) {
+        using namespace detail;
+
+        if (nElements != table::nElements
+            || input.meshGrading != table::meshGrading
+            || input.integrationScheme != table::integrationScheme)
+            return false;
+
+        // the ratio only matters for the geometric grading
+        if (input.meshGrading == (unsigned) MeshGrading::Geometric
+            && !near(input.gradingRatio, table::gradingRatio))
+            return false;
+
+        if (!near(input.alphaAir, table::alphaAir) || !near(input.C, table::C)
+            || !near(input.Ro, table::Ro) || !near(input.K, table::K))
+            return false;
+
+        return tau >= table::tauMin && tau <= table::tauMax
+            && input.r >= table::rMin && input.r <= table::rMax;
+    }
+
+    /*
+        Temperatures after `tau` [s] in the furnace at `tFurnace` [deg C], of a wire of radius
+        `r` [m] that entered it at `t0` [deg C]. Only within the table - see `covers`.
+    */
+    inline Result evaluate(float tau, float r, float t0, float tFurnace) {
+        using namespace detail;
+
+        // the radii are in a geometric progression
+        static const float rScale = (table::nR - 1) / log(table::rMax / table::rMin);
+
+        float iTau = position(tau, table::tauMin, table::tauMax, table::nTau);
+        float iR = log(r / table::rMin) * rScale;
+        float span = tFurnace - t0;
+
+        return {
+            t0 + span * lookup(table::core, iR, iTau),
+            t0 + span * lookup(table::surface, iR, iTau),
+            (table::interpolationError + table::timeStepError) * fabs(span)
+        };
+    }
+} // namespace surrogate
+
+#endif
@@ -0,0 +1,202 @@
+#ifndef SURROGATE_TABLE_HEADER_GUARD
+#define SURROGATE_TABLE_HEADER_GUARD
+
+/* Generated by PCversion/surrogate, see Surrogate.h */
+
+namespace surrogate {
+    namespace table {
+        // parameters the table was generated with
+        constexpr int nElements = 10;
+        constexpr unsigned meshGrading = 0;
+        constexpr float gradingRatio = 1;
+        constexpr unsigned integrationScheme = 1;
+        constexpr float alphaAir = 300;
+        constexpr float C = 700;
+        constexpr float Ro = 7800;
+        constexpr float K = 25;
+
+        // time in the furnace [s]
+        constexpr float tauMin = 0.05;
+        constexpr float tauMax = 2;
+        constexpr uint8_t nTau = 32;
+
+        // wire radius [m], in a geometric progression
+        constexpr float rMin = 0.0005;
+        constexpr float rMax = 0.005;
+        constexpr uint8_t nR = 16;
+
+        // largest errors of the response, of the interpolation and of the 1000 time steps,
+        // from the converged solution - the steps of the sketch add their own
+        constexpr float interpolationError = 0.0006036814;
+        constexpr float timeStepError = 0.0001601839;
+
+        // (t - t0) / (tFurnace - t0) at the end of the furnace, in 1/65535
+        const uint16_t core[nR][nTau] PROGMEM = {
+            {
+                1225, 2974, 4675, 6330, 7939, 9505, 11028, 12510, 13952, 15354, 16718, 18045,
+                19336, 20591, 21813, 23001, 24157, 25282, 26376, 27440, 28475, 29482, 30462, 31415,
+                32342, 33244, 34122, 34975, 35805, 36613, 37399, 38163,
+            },
+            {
+                992, 2499, 3971, 5409, 6813, 8184, 9524, 10831, 12109, 13356, 14575, 15765,
+                16927, 18062, 19170, 20252, 21310, 22342, 23351, 24335, 25297, 26236, 27154, 28050,
+                28925, 29779, 30614, 31429, 32225, 33002, 33762, 34503,
+            },
+            {
+                781, 2079, 3351, 4598, 5820, 7018, 8191, 9341, 10468, 11572, 12654, 13714,
+                14753, 15771, 16769, 17746, 18704, 19643, 20563, 21465, 22348, 23214, 24062, 24893,
+                25708, 26506, 27289, 28055, 28806, 29542, 30264, 30971,
+            },
+            {
+                589, 1705, 2804, 3883, 4945, 5987, 7012, 8020, 9010, 9982, 10938, 11878,
+                12801, 13709, 14601, 15477, 16339, 17185, 18017, 18835, 19639, 20428, 21205, 21967,
+                22717, 23454, 24178, 24889, 25589, 26276, 26951, 27615,
+            },
+            {
+                417, 1369, 2317, 3251, 4171, 5077, 5970, 6849, 7716, 8570, 9411, 10240,
+                11057, 11861, 12654, 13435, 14204, 14962, 15709, 16445, 17170, 17884, 18587, 19281,
+                19964, 20636, 21299, 21952, 22596, 23230, 23854, 24470,
+            },
+            {
+                268, 1065, 1881, 2687, 3484, 4270, 5046, 5812, 6569, 7316, 8054, 8782,
+                9501, 10211, 10912, 11604, 12287, 12961, 13627, 14285, 14934, 15575, 16208, 16833,
+                17449, 18059, 18660, 19254, 19840, 20419, 20990, 21554,
+            },
+            {
+                151, 788, 1487, 2183, 2871, 3552, 4225, 4891, 5550, 6202, 6847, 7484,
+                8115, 8739, 9356, 9966, 10570, 11167, 11757, 12342, 12919, 13491, 14056, 14616,
+                15169, 15716, 16257, 16792, 17322, 17845, 18364, 18876,
+            },
+            {
+                70, 542, 1128, 1726, 2320, 2909, 3492, 4070, 4642, 5210, 5771, 6328,
+                6880, 7426, 7967, 8503, 9034, 9561, 10082, 10598, 11110, 11617, 12119, 12617,
+                13109, 13598, 14081, 14561, 15035, 15506, 15971, 16433,
+            },
+            {
+                24, 335, 805, 1310, 1820, 2328, 2832, 3333, 3829, 4322, 4811, 5295,
+                5776, 6253, 6726, 7196, 7662, 8124, 8582, 9036, 9487, 9935, 10379, 10819,
+                11256, 11689, 12119, 12545, 12968, 13387, 13804, 14217,
+            },
+            {
+                5, 178, 524, 934, 1364, 1799, 2234, 2666, 3096, 3523, 3947, 4368,
+                4787, 5202, 5615, 6025, 6432, 6836, 7237, 7636, 8032, 8425, 8816, 9203,
+                9589, 9971, 10351, 10729, 11103, 11476, 11845, 12212,
+            },
+            {
+                0, 76, 299, 608, 955, 1318, 1688, 2059, 2429, 2798, 3165, 3530,
+                3894, 4255, 4613, 4970, 5325, 5678, 6028, 6377, 6723, 7068, 7410, 7751,
+                8089, 8425, 8760, 9092, 9423, 9752, 10078, 10403,
+            },
+            {
+                0, 23, 142, 347, 605, 892, 1195, 1506, 1820, 2136, 2452, 2767,
+                3081, 3394, 3705, 4015, 4323, 4630, 4936, 5240, 5542, 5843, 6142, 6440,
+                6736, 7031, 7324, 7616, 7907, 8196, 8483, 8769,
+            },
+            {
+                0, 4, 51, 165, 333, 539, 769, 1016, 1272, 1535, 1801, 2069,
+                2338, 2606, 2875, 3143, 3410, 3676, 3941, 4205, 4468, 4730, 4991, 5251,
+                5509, 5767, 6023, 6279, 6533, 6786, 7038, 7289,
+            },
+            {
+                0, 0, 12, 59, 149, 276, 433, 611, 804, 1010, 1223, 1442,
+                1664, 1890, 2117, 2345, 2573, 2802, 3030, 3258, 3486, 3713, 3939, 4165,
+                4390, 4614, 4837, 5060, 5282, 5503, 5723, 5942,
+            },
+            {
+                0, 0, 1, 14, 49, 112, 200, 311, 441, 585, 741, 907,
+                1080, 1259, 1442, 1628, 1817, 2007, 2199, 2392, 2586, 2780, 2974, 3168,
+                3362, 3555, 3748, 3941, 4134, 4326, 4518, 4709,
+            },
+            {
+                0, 0, 0, 1, 10, 31, 69, 125, 196, 283, 382, 493,
+                614, 742, 877, 1018, 1164, 1314, 1467, 1622, 1780, 1939, 2100, 2262,
+                2425, 2588, 2752, 2916, 3080, 3245, 3409, 3574,
+            },
+        };
+
+        const uint16_t surface[nR][nTau] PROGMEM = {
+            {
+                1612, 3350, 5041, 6686, 8286, 9842, 11356, 12829, 14262, 15656, 17011, 18330,
+                19614, 20862, 22076, 23257, 24406, 25524, 26611, 27669, 28698, 29699, 30673, 31620,
+                32542, 33438, 34311, 35159, 35984, 36787, 37568, 38328,
+            },
+            {
+                1444, 2941, 4403, 5830, 7225, 8586, 9916, 11215, 12483, 13722, 14932, 16113,
+                17267, 18394, 19495, 20570, 21620, 22645, 23646, 24624, 25579, 26512, 27423, 28312,
+                29181, 30030, 30859, 31668, 32458, 33230, 33984, 34721,
+            },
+            {
+                1309, 2597, 3859, 5096, 6308, 7495, 8659, 9800, 10917, 12012, 13085, 14137,
+                15167, 16177, 17167, 18136, 19087, 20018, 20930, 21824, 22701, 23559, 24401, 25225,
+                26033, 26825, 27601, 28361, 29106, 29836, 30552, 31253,
+            },
+            {
+                1204, 2312, 3400, 4470, 5521, 6554, 7569, 8567, 9547, 10511, 11458, 12388,
+                13303, 14202, 15085, 15953, 16807, 17645, 18469, 19279, 20075, 20857, 21626, 22382,
+                23124, 23854, 24571, 25276, 25968, 26649, 27318, 27976,
+            },
+            {
+                1125, 2080, 3017, 3940, 4850, 5746, 6629, 7499, 8356, 9201, 10033, 10852,
+                11660, 12456, 13239, 14012, 14773, 15522, 16261, 16988, 17705, 18411, 19107, 19793,
+                20468, 21134, 21789, 22435, 23071, 23698, 24316, 24925,
+            },
+            {
+                1066, 1895, 2702, 3498, 4284, 5060, 5826, 6582, 7329, 8067, 8795, 9514,
+                10223, 10924, 11616, 12299, 12973, 13639, 14296, 14946, 15586, 16219, 16844, 17460,
+                18069, 18671, 19264, 19850, 20429, 21000, 21564, 22121,
+            },
+            {
+                1023, 1753, 2448, 3133, 3811, 4482, 5145, 5801, 6450, 7092, 7727, 8355,
+                8977, 9591, 10199, 10800, 11395, 11983, 12564, 13140, 13709, 14272, 14829, 15380,
+                15925, 16464, 16997, 17524, 18045, 18561, 19071, 19576,
+            },
+            {
+                989, 1646, 2249, 2840, 3424, 4002, 4575, 5143, 5706, 6263, 6815, 7362,
+                7904, 8441, 8972, 9499, 10021, 10538, 11050, 11558, 12061, 12559, 13052, 13541,
+                14025, 14505, 14980, 15451, 15917, 16379, 16837, 17290,
+            },
+            {
+                963, 1568, 2099, 2610, 3113, 3612, 4106, 4597, 5083, 5566, 6044, 6519,
+                6990, 7458, 7921, 8381, 8837, 9290, 9739, 10184, 10626, 11064, 11499, 11930,
+                12358, 12783, 13204, 13622, 14036, 14447, 14855, 15259,
+            },
+            {
+                942, 1509, 1988, 2436, 2872, 3302, 3728, 4151, 4571, 4988, 5402, 5814,
+                6222, 6628, 7031, 7431, 7828, 8223, 8615, 9004, 9390, 9774, 10156, 10534,
+                10911, 11284, 11655, 12024, 12390, 12753, 13114, 13472,
+            },
+            {
+                924, 1464, 1905, 2307, 2691, 3065, 3434, 3799, 4161, 4520, 4878, 5233,
+                5587, 5938, 6287, 6634, 6979, 7322, 7663, 8002, 8339, 8674, 9007, 9338,
+                9667, 9994, 10319, 10643, 10964, 11284, 11602, 11917,
+            },
+            {
+                909, 1428, 1843, 2212, 2557, 2888, 3211, 3528, 3842, 4153, 4461, 4768,
+                5073, 5376, 5678, 5978, 6277, 6574, 6870, 7164, 7456, 7748, 8037, 8326,
+                8613, 8898, 9182, 9465, 9746, 10025, 10304, 10581,
+            },
+            {
+                896, 1398, 1793, 2139, 2458, 2758, 3046, 3327, 3602, 3873, 4141, 4407,
+                4670, 4933, 5193, 5452, 5711, 5967, 6223, 6478, 6731, 6983, 7235, 7485,
+                7734, 7982, 8229, 8475, 8720, 8963, 9206, 9448,
+            },
+            {
+                885, 1374, 1753, 2082, 2381, 2660, 2924, 3178, 3425, 3666, 3902, 4135,
+                4366, 4594, 4820, 5045, 5268, 5490, 5711, 5931, 6151, 6369, 6586, 6803,
+                7018, 7233, 7447, 7660, 7873, 8084, 8295, 8505,
+            },
+            {
+                873, 1352, 1720, 2036, 2320, 2583, 2831, 3067, 3293, 3512, 3726, 3935,
+                4140, 4342, 4541, 4739, 4934, 5128, 5320, 5511, 5701, 5891, 6079, 6266,
+                6453, 6639, 6824, 7009, 7192, 7376, 7558, 7740,
+            },
+            {
+                862, 1334, 1692, 1998, 2271, 2522, 2757, 2979, 3192, 3396, 3594, 3785,
+                3973, 4156, 4336, 4513, 4687, 4859, 5029, 5198, 5365, 5531, 5696, 5859,
+                6022, 6184, 6345, 6505, 6664, 6823, 6982, 7139,
+            },
+        };
+    } // namespace table
+} // namespace surrogate
+
+#endif
@@ -0,0 +1,290 @@
+#ifndef TEMPERATURE_SAMPLER_HEADER_GUARD
+#define TEMPERATURE_SAMPLER_HEADER_GUARD
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+/*
+    MAX31855 read straight through the port registers. The chip sends a 32 bit frame:
+
+        31-18 thermocouple temperature, 0.25 deg C | 16 fault | 15-4 cold junction temperature,
+        0.0625 deg C | 2 short to VCC | 1 short to GND | 0 open circuit
+
+    A read takes some 50 us, short enough for an interrupt. A new conversion starts
+    after every read and takes up to 100 ms, reading more often gives the same value again.
+*/
+class Max31855 {
+    uint8_t clk, cs, data;
+    volatile uint8_t* clkPort;
+    volatile uint8_t* csPort;
+    volatile uint8_t* dataPin;
+    uint8_t clkMask, csMask, dataMask;
+
+public:
+    enum Fault : uint8_t {
+        OpenCircuit = 1,
+        ShortToGround = 2,
+        ShortToVcc = 4,
+        // nothing answers - the frame is all zeros or ones
+        NoDevice = 8,
+        // no valid reading for a few sampling periods
+        Stale = 16
+    };
+
+    Max31855(uint8_t clk, uint8_t cs, uint8_t data): clk(clk), cs(cs), data(data) {}
+
+    void begin() {
+        clkPort = portOutputRegister(digitalPinToPort(clk));
+        csPort = portOutputRegister(digitalPinToPort(cs));
+        dataPin = portInputRegister(digitalPinToPort(data));
+        clkMask = digitalPinToBitMask(clk);
+        csMask = digitalPinToBitMask(cs);
+        dataMask = digitalPinToBitMask(data);
+
+        pinMode(clk, OUTPUT);
+        pinMode(cs, OUTPUT);
+        pinMode(data, INPUT);
+
+        digitalWrite(cs, HIGH);
+        digitalWrite(clk, LOW);
+    }
+
+    uint32_t read() {
+        uint32_t frame = 0;
+
+        *csPort &= ~csMask;
+        // the first bit is ready 100 ns after the chip select
+        delayMicroseconds(1);
+
+        // the chip shifts out the next bit on the falling edge of the clock
+        for (uint8_t i = 0; i < 32; i++) {
+            frame <<= 1;
+
+            if (*dataPin & dataMask)
+                frame |= 1;
+
+            *clkPort |= clkMask;
+            *clkPort &= ~clkMask;
+        }
+
+        *csPort |= csMask;
+
+        return frame;
+    }
+
+    static uint8_t faults(uint32_t frame) {
+        if (frame == 0 || frame == 0xFFFFFFFF)
+            return NoDevice;
+
+        return frame & 0x10000 ? frame & 0x07 : 0;
+    }
+
+    // [deg C]
+    static float celsius(uint32_t frame) {
+        return ((int32_t) frame >> 18) * 0.25f;
+    }
+
+    static float coldJunction(uint32_t frame) {
+        return ((int16_t) frame >> 4) * 0.0625f;
+    }
+};
+
+/*
+    Furnace temperature, sampled at a fixed rate in the Timer1 compare interrupt. The interrupt
+    only reads the frame and queues it with its time, so it holds the solver up for about 50 us
+    and never waits for it - when the queue is full, the sample is lost (counted in
+    `overruns`). `update`, called from the main loop, decodes the queued frames, and passes the
+    valid ones through a median of 3, which removes single spikes, and an exponential filter
+    with the weight `alpha` of the new value. The filtered samples are kept, with their times,
+    in a ring of `historySize`, and `at` interpolates between them.
+
+    Without the timer, `add` takes the samples from elsewhere (the PC in DEBUG_SERIAL_TEMP mode).
+*/
+template<uint8_t historySize>
+class TemperatureSampler {
+    static_assert(historySize >= 2, "The interpolation needs at least two samples");
+
+    struct Raw {
+        unsigned long time;     // [ms]
+        uint32_t frame;
+    };
+
+    struct Sample {
+        unsigned long time;     // [ms]
+        float t;                // [deg C]
+    };
+
+    static constexpr uint8_t queueSize = 4;
+
+    Max31855 sensor;
+
+    // the head is moved only by the interrupt and the tail only by `update`, both single bytes,
+    // so neither side has to disable the interrupts
+    volatile Raw queue[queueSize];
+    volatile uint8_t queueHead = 0;
+    volatile uint8_t queueTail = 0;
+    volatile uint16_t nOverruns = 0;
+
+    const float alpha;
+    const bool median;
+    uint16_t period = 0;
+
+    float recent[3];
+    uint8_t nRecent = 0;
+    float filtered = NAN;
+
+    Sample history[historySize];
+    uint8_t newest = 0;
+    uint8_t count = 0;
+
+    uint8_t currentFaults = 0;
+    float lastColdJunction = NAN;
+
+    float medianOfRecent() const {
+        if (nRecent < 3)
+            return recent[nRecent - 1];
+
+        float a = recent[0], b = recent[1], c = recent[2];
+
+        if (a > b) {
+            float s = a;
+            a = b;
+            b = s;
+        }
+
+        return c < a ? a : c > b ? b : c;
+    }
+
+    const Sample& sample(uint8_t age) const {
+        return history[(newest + historySize - age) % historySize];
+    }
+
+public:
+    TemperatureSampler(uint8_t clk, uint8_t cs, uint8_t data, float alpha, bool median):
+        sensor(clk, cs, data),
+        alpha(alpha),
+        median(median)
+    {}
+
+    /*
+        Starts reading the thermocouple every `period` [ms], up to about 1 s. Timer1 runs in the
+        CTC mode with the prescaler of 256, so the ISR for TIMER1_COMPA_vect has to call
+        `onTimer`.
+    */
+    void start(uint16_t period) {
+        this->period = period;
+        sensor.begin();
+
+        uint8_t sreg = SREG;
+        cli();
+
+        TCCR1A = 0;
+        TCCR1B = _BV(WGM12) | _BV(CS12);
+        TCNT1 = 0;
+        OCR1A = (F_CPU / 256) * period / 1000 - 1;
+        TIMSK1 |= _BV(OCIE1A);
+
+        SREG = sreg;
+    }
+
+    // From the timer interrupt
+    void onTimer() {
+        uint8_t next = (queueHead + 1) % queueSize;
+
+        if (next == queueTail) {
+            nOverruns++;
+            return;
+        }
+
+        queue[queueHead].frame = sensor.read();
+        queue[queueHead].time = millis();
+        queueHead = next;
+    }
+
+    // Adds a sample of the temperature `t` [deg C], taken at `time` [ms]
+    void add(unsigned long time, float t) {
+        if (nRecent == 3) {
+            recent[0] = recent[1];
+            recent[1] = recent[2];
+            nRecent--;
+        }
+
+        recent[nRecent++] = t;
+
+        float value = median ? medianOfRecent() : t;
+        filtered = isnan(filtered) ? value : filtered + alpha*(value - filtered);
+
+        newest = (newest + 1) % historySize;
+        history[newest] = { time, filtered };
+
+        if (count < historySize)
+            count++;
+    }
+
+    // Processes the frames queued by the interrupt, `now` is the current time [ms]
+    void update(unsigned long now) {
+        while (queueTail != queueHead) {
+            uint32_t frame = queue[queueTail].frame;
+            unsigned long time = queue[queueTail].time;
+            queueTail = (queueTail + 1) % queueSize;
+
+            currentFaults = Max31855::faults(frame);
+
+            if (currentFaults == 0) {
+                add(time, Max31855::celsius(frame));
+                lastColdJunction = Max31855::coldJunction(frame);
+            }
+        }
+
+        if (period > 0 && (count == 0 || now - sample(0).time > 3ul*period))
+            currentFaults |= Max31855::Stale;
+    }
+
+    /*
+        Filtered temperature at `time` [ms], interpolated between the samples around it. Before
+        the oldest sample kept it is the oldest one, after the newest - the newest one, there is
+        no extrapolation. NaN before the first sample.
+    */
+    float at(unsigned long time) const {
+        if (count == 0)
+            return NAN;
+
+        // compared as differences, so that it works across the overflow of millis
+        if ((long) (time - sample(0).time) >= 0)
+            return sample(0).t;
+
+        for (uint8_t age = 1; age < count; age++) {
+            const Sample& before = sample(age);
+            const Sample& after = sample(age - 1);
+
+            if ((long) (time - before.time) >= 0) {
+                float f = (float) (time - before.time) / (after.time - before.time);
+                return before.t + f*(after.t - before.t);
+            }
+        }
+
+        return sample(count - 1).t;
+    }
+
+    float latest() const { return count > 0 ? sample(0).t : NAN; }
+
+    // there is a sample, and the last reading was not faulty
+    bool valid() const { return count > 0 && currentFaults == 0; }
+
+    // Max31855::Fault flags of the last reading
+    uint8_t faults() const { return currentFaults; }
+
+    float coldJunction() const { return lastColdJunction; }
+
+    // samples lost because the queue was full
+    uint16_t overruns() const {
+        uint8_t sreg = SREG;
+        cli();
+        uint16_t n = nOverruns;
+        SREG = sreg;
+
+        return n;
+    }
+};
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef CYCLE_COUNTER_HEADER_GUARD
+#define CYCLE_COUNTER_HEADER_GUARD
+
+#include <Arduino.h>
+
+/*
+    Counts CPU cycles with Timer1 running at the CPU clock. Its overflows are counted by an
+    interrupt whose own cycles are known (it is written in assembly) and subtracted, as is the
+    cost of starting and stopping the counter, so the result is the cycles of the code between
+    start() and stop() alone. The corrections are counted from the instructions, and have not
+    been checked under simavr or on a board yet; on a board, any other enabled interrupt adds to
+    the count.
+*/
+extern "C" volatile uint16_t cycleOverflows;
+volatile uint16_t cycleOverflows;
+
+ISR(TIMER1_OVF_vect, ISR_NAKED) {
+    // 16-bit increment, subtracting -1 - the carry of the low byte is inverted
+    __asm__ __volatile__(
+        "push r24                     \n\t"
+        "in r24, __SREG__             \n\t"
+        "push r24                     \n\t"
+        "lds r24, cycleOverflows      \n\t"
+        "subi r24, 0xff               \n\t"
+        "sts cycleOverflows, r24      \n\t"
+        "lds r24, cycleOverflows+1    \n\t"
+        "sbci r24, 0xff               \n\t"
+        "sts cycleOverflows+1, r24    \n\t"
+        "pop r24                      \n\t"
+        "out __SREG__, r24            \n\t"
+        "pop r24                      \n\t"
+        "reti                         \n\t"
+    );
+}
+
+namespace cycles {
+    // interrupt response and the vector jump (7), the handler above (24)
+    constexpr uint8_t perOverflow = 31;
+
+    uint8_t overhead = 0;
+
+    __attribute__((always_inline)) inline void start() {
+        TCCR1B = 0;
+        TCCR1A = 0;
+        TCNT1 = 0;
+        cycleOverflows = 0;
+        TIFR1 = _BV(TOV1);
+        TIMSK1 = _BV(TOIE1);
+        sei();
+        TCCR1B = _BV(CS10);
+    }
+
+    __attribute__((always_inline)) inline uint32_t stop() {
+        cli();
+        TCCR1B = 0;
+
+        uint16_t ticks = TCNT1;
+        uint16_t n = cycleOverflows;
+        uint16_t pending = 0;
+
+        // an overflow in the last cycles, which the interrupt did not handle
+        if (TIFR1 & _BV(TOV1)) {
+            TIFR1 = _BV(TOV1);
+            pending = 1;
+        }
+
+        return ((uint32_t) (n + pending) << 16) + ticks - (uint32_t) n * perOverflow - overhead;
+    }
+
+    // Measures the cost of start() and stop() themselves, subtracted from then on
+    void calibrate() {
+        overhead = 0;
+        start();
+        overhead = stop();
+    }
+} // namespace cycles
+
+#endif
@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+import csv
+import sys
+from argparse import ArgumentParser
+
+"""
+    Compares two results of the simulator profiling (see Makefile) and exits with 1 if any value
+    in the new one exceeds its baseline by more than the tolerance. All the metrics are cycles or
+    bytes, so more is worse. Results present in just one of the files are listed, but not failed.
+"""
+
+def load(path):
+    with open(path, newline='') as file:
+        return {
+            (row['elements'], row['type'], row['order'], row['scheme'], row['metric']): int(row['value'])
+            for row in csv.DictReader(file)
+        }
+
+parser = ArgumentParser(description='Compares profiling results with a baseline')
+parser.add_argument('baseline')
+parser.add_argument('current')
+parser.add_argument('--tolerance', type=float, default=2, help='allowed increase [%%]')
+args = parser.parse_args()
+
+try:
+    baseline = load(args.baseline)
+except FileNotFoundError:
+    sys.exit(f'No baseline in {args.baseline}, create it with "make baseline"')
+
+current = load(args.current)
+regressions = 0
+
+for key in sorted(baseline.keys() | current.keys()):
+    name = '/'.join(key)
+
+    if key not in current or key not in baseline:
+        print(f'{name:50} only in {args.baseline if key in baseline else args.current}')
+        continue
+
+    old, new = baseline[key], current[key]
+    change = 100 * (new - old) / old if old else 0
+    regressed = change > args.tolerance
+    regressions += regressed
+
+    print(f'{name:50} {old:>10} {new:>10} {change:+8.2f} %{"  REGRESSION" if regressed else ""}')
+
+print(f'{regressions} regression(s) above {args.tolerance} %')
+exit(1 if regressions else 0)
@@ -0,0 +1,177 @@
+/*
+    Profiling firmware for the simulator: runs the simulation core of the sketch on the mesh
+    size, value type and element order it is built with, and reports the cycles of every phase
+    of a step, for each integration scheme, over the UART as lines of
+
+        profile,<elements>,<value type>,<order>,<scheme>,<metric>,<value>
+
+    The metrics are:
+        assembly        - assembly of the system, without its factorization
+        factorization   - factorization of the assembled system
+        solve           - solve with the factorized system
+        step            - step with the assembled system (right-hand side, solve, update),
+                          averaged over `nSteps` steps
+        step_uncached   - step assembling the system from scratch
+        modal_decompose - eigen-decomposition for the modal solver, all the modes (linear
+                          elements only)
+        modal_step      - modal step, of any length
+        mesh_bytes      - SRAM taken by the mesh, with its system (scheme 0)
+        system_bytes    - SRAM taken by one system (scheme 0)
+*/
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include "CycleCounter.h"
+
+// the fields of the sketch input the simulation core reads, with the same defaults - Mesh.h
+// uses them, so it comes after
+struct Input {
+    float alphaAir = 300;   // [W/(m^2*K)]
+    float C = 700.0;        // [J/(kg*K)]
+    float Ro = 7800.0;      // [kg/m^3]
+    float K = 25.0;         // [W/m*K]
+};
+
+#include "Mesh.h"
+#include "ModalSolver.h"
+
+#ifndef MESH_SIZE
+#define MESH_SIZE 10
+#endif
+
+#ifndef MESH_VALUE_TYPE
+#define MESH_VALUE_TYPE float
+#endif
+
+#ifndef ELEMENT_ORDER
+#define ELEMENT_ORDER 1
+#endif
+
+#define STRINGIFY_VALUE(x) #x
+#define STRINGIFY(x) STRINGIFY_VALUE(x)
+
+namespace profile {
+    constexpr int nElements = MESH_SIZE;
+    constexpr int nNodes = nElements + 1;
+    using Value = MESH_VALUE_TYPE;
+    using MeshT = Mesh<nNodes, Value, ELEMENT_ORDER>;
+    using Coefficient = MeshT::Coefficient;
+
+    constexpr float rMax = 0.002;       // [m]
+    constexpr float dTau = 0.02;        // [s]
+    constexpr float t0 = 20;            // [deg C]
+    constexpr float tAmbient = 800;     // [deg C]
+    constexpr uint8_t nSteps = 20;
+
+    MeshT mesh;
+    Input input;
+
+    void report(uint8_t scheme, const char* metric, uint32_t value) {
+        Serial.print("profile,");
+        Serial.print(nElements);
+        Serial.print(",");
+        Serial.print(STRINGIFY(MESH_VALUE_TYPE));
+        Serial.print(",");
+        Serial.print(ELEMENT_ORDER);
+        Serial.print(",");
+        Serial.print(scheme);
+        Serial.print(",");
+        Serial.print(metric);
+        Serial.print(",");
+        Serial.println(value);
+    }
+
+    /*
+        The assembly ends with the factorization of K, so to time the two apart, K is rebuilt
+        from its factors and factorized again. The rows are scaled to a unit diagonal, and the
+        factorization keeps the upper diagonal, so only the lower one has to be multiplied back
+        by the pivots.
+    */
+    uint32_t factorization() {
+        const auto& factors = mesh.system.K.storage;
+        TridiagMat<nNodes, Coefficient> K;
+
+        for (int i = 0; i < nNodes; i++) {
+            K.storage.diag(i) = Coefficient(1);
+
+            if (i < nNodes-1) {
+                K.storage.upper(i) = factors.upper(i);
+                K.storage.lower(i) = factors.lower(i) / factors.diag(i);
+            }
+        }
+
+        cycles::start();
+        BLA::LUDecompose(K);
+        return cycles::stop();
+    }
+
+    void run(uint8_t scheme) {
+        mesh.fill(t0);
+        mesh.selectIntegrationScheme(scheme);
+        mesh.restartCycle();
+
+        cycles::start();
+        mesh.assemble(mesh.system, dTau, rMax, input);
+        uint32_t assembly = cycles::stop();
+
+        uint32_t factorized = factorization();
+        report(scheme, "assembly", assembly - factorized);
+        report(scheme, "factorization", factorized);
+
+        Value t[nNodes];
+
+        for (int i = 0; i < nNodes; i++)
+            t[i] = mesh.nodes[i].t;
+
+        cycles::start();
+        mesh.system.K.storage.solve(t);
+        report(scheme, "solve", cycles::stop());
+
+        uint32_t steps = 0;
+
+        for (uint8_t i = 0; i < nSteps; i++) {
+            cycles::start();
+            mesh.integrateStep(mesh.system, tAmbient);
+            steps += cycles::stop();
+        }
+
+        report(scheme, "step", steps / nSteps);
+
+        cycles::start();
+        mesh.integrateStep(dTau, rMax, tAmbient, input);
+        report(scheme, "step_uncached", cycles::stop());
+
+        #if ELEMENT_ORDER == 1
+        ModalSolver<nNodes, Value> modal{mesh};
+
+        cycles::start();
+        modal.decompose(rMax, input);
+        report(scheme, "modal_decompose", cycles::stop());
+
+        cycles::start();
+        modal.step(dTau * nSteps, tAmbient);
+        report(scheme, "modal_step", cycles::stop());
+        #endif
+    }
+} // namespace profile
+
+int main() {
+    Serial.begin(115200);
+    cycles::calibrate();
+
+    profile::mesh.generate(profile::t0, profile::rMax / profile::nElements);
+
+    profile::report(0, "mesh_bytes", sizeof(profile::MeshT));
+    profile::report(0, "system_bytes", sizeof(profile::MeshT::System));
+
+    for (uint8_t scheme = 1; scheme <= 4; scheme++)
+        profile::run(scheme);
+
+    Serial.println("done");
+    Serial.flush();
+
+    // sleeping with the interrupts disabled ends the simulation
+    cli();
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+    sleep_enable();
+    sleep_cpu();
+}
@@ -0,0 +1,59 @@
+#ifndef ARDUINO_STUB_HEADER_GUARD
+#define ARDUINO_STUB_HEADER_GUARD
+
+/*
+    The part of the Arduino core the simulation code uses, on top of plain avr-libc, so that
+    it builds without the core and without any hardware library. Serial writes straight to the
+    UART, which the simulator prints.
+*/
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "Print.h"
+
+typedef uint8_t byte;
+
+class StubSerial : public Print {
+    bool sending = false;
+
+public:
+    void begin(unsigned long baud) {
+        uint16_t ubrr = F_CPU / 8 / baud - 1;
+
+        UCSR0A = _BV(U2X0);
+        UBRR0H = ubrr >> 8;
+        UBRR0L = ubrr;
+        UCSR0B = _BV(TXEN0);
+        UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+    }
+
+    size_t write(uint8_t c) override {
+        while (!(UCSR0A & _BV(UDRE0)))
+            ;
+
+        // clears the transmit complete flag, so that flush can wait for this byte
+        UCSR0A = _BV(U2X0) | _BV(TXC0);
+        UDR0 = c;
+        sending = true;
+        return 1;
+    }
+
+    using Print::write;
+
+    // Waits until the last byte is sent, so that it is not lost when the program stops
+    void flush() {
+        if (!sending)
+            return;
+
+        while (!(UCSR0A & _BV(TXC0)))
+            ;
+    }
+};
+
+inline StubSerial Serial;
+
+#endif
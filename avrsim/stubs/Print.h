@@ -0,0 +1,51 @@
+#ifndef PRINT_STUB_HEADER_GUARD
+#define PRINT_STUB_HEADER_GUARD
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+class __FlashStringHelper;
+class String;
+class Printable;
+
+// Just the text and integer printing of the Arduino Print
+class Print {
+public:
+    virtual size_t write(uint8_t c) = 0;
+
+    size_t write(const char* s) {
+        size_t n = 0;
+
+        while (*s)
+            n += write((uint8_t) *s++);
+
+        return n;
+    }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(char c) { return write((uint8_t) c); }
+
+    size_t print(unsigned long value) {
+        char buffer[11];
+        return write(ultoa(value, buffer, 10));
+    }
+
+    size_t print(long value) {
+        char buffer[12];
+        return write(ltoa(value, buffer, 10));
+    }
+
+    size_t print(unsigned value) { return print((unsigned long) value); }
+    size_t print(int value) { return print((long) value); }
+
+    size_t println() { return write('\n'); }
+
+    template<typename T>
+    size_t println(T value) {
+        size_t n = print(value);
+        return n + println();
+    }
+};
+
+#endif
@@ -1,121 +1,151 @@
-from math import nan
 import struct
 from dataclasses import dataclass, field
-from typing import List
+from typing import List, Union
 from serial import Serial
 from enum import IntEnum
 from datetime import timedelta
 
-class PacketType(IntEnum):
-    InvalidPacket = 0
-    IterationData = 1
-    BenchmarkData = 2
+"""
+    Telemetry frames sent by the Arduino, mirrors `communication.h` - see there for the format.
+"""
 
-@dataclass
-class Packet:
-    type: PacketType = PacketType.InvalidPacket
-    length: int = 0
+SYNC = b'\xa5\x5a'
+# sync, type and length before the payload, CRC after it
+HEADER_SIZE = 4
+CRC_SIZE = 2
 
-    def unpackHeader(self, serial: Serial):
-        data = serial.read(2*2)
-        type, length = struct.unpack('HH', data)
-        self.type = type
-        self.length = length
+TEMPERATURE_SCALE = 16
 
-    @staticmethod
-    def readFromSerial(serial: Serial):
-        packetBase = Packet()
-        packetBase.unpackHeader(serial)
+class FrameType(IntEnum):
+    InvalidFrame = 0
+    MeshInfo = 1
+    Iterations = 2
+
+class BatchFlags(IntEnum):
+    CycleEnd = 1
+
+def crc16(data: bytes, crc: int = 0xFFFF) -> int:
+    """ CRC-16/CCITT-FALSE """
+    for byte in data:
+        crc ^= byte << 8
 
-        PacketClass = packetMap.get(packetBase.type, None)
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
 
-        if not PacketClass:
-            return
+    return crc
 
-        packet = PacketClass()
-        packet.type = packetBase.type
-        packet.length = packetBase.length
-        packet.unpackFromSerial(serial, unpackHeader=False)
+@dataclass
+class MeshInfo:
+    nNodes: int = 0
+    nIterations: int = 0
+    tauEnd: float = 0
+    # frames that did not fit in the send queue of the Arduino, and steps left out because of it
+    droppedFrames: int = 0
+    coalescedIterations: int = 0
+    radii: List[float] = field(default_factory=list)
 
-        return packet
+    @staticmethod
+    def unpack(payload: bytes) -> 'MeshInfo':
+        nNodes, nIterations, tauEnd, dropped, coalesced = struct.unpack_from('<BHfHH', payload)
+        radii = list(struct.unpack_from(f'<{nNodes}f', payload, 11))
 
+        return MeshInfo(nNodes, nIterations, tauEnd, dropped, coalesced, radii)
 
 @dataclass
-class ArduinoIterationPacket(Packet):
-    tau: float = 0
+class Iteration:
     iteration: int = 0
-    nIterations: int = 0
-    nNodes: int = 0
-    nodeSize: int = 0
-    nodes: List['Node'] = field(default_factory=list)
+    tau: float = 0
+    arduinoDurationMicros: int = 0
+    # node temperatures [deg C], from the axis to the surface
+    temperatures: List[float] = field(default_factory=list)
 
-    @dataclass
-    class Node:
-        t: float = 0
-        x: float = 0
+@dataclass
+class IterationBatch:
+    cycleEnd: bool = False
+    iterations: List[Iteration] = field(default_factory=list)
 
-        def unpack(self, data: bytes):
-            t, x = struct.unpack('ff', data)
-            self.t = t
-            self.x = x
+    @staticmethod
+    def unpack(payload: bytes) -> 'IterationBatch':
+        firstIteration, lastIteration, flags, count, nNodes = struct.unpack_from('<HHBBB', payload)
+        batch = IterationBatch(cycleEnd=bool(flags & BatchFlags.CycleEnd))
+        offset = 7
 
-    def unpackFromSerial(self, serial: Serial, unpackHeader = True) -> None:
-        self.nodes.clear()
+        for k in range(count):
+            tau, duration = struct.unpack_from('<fH', payload, offset)
+            temperatures = struct.unpack_from(f'<{nNodes}h', payload, offset + 6)
+            offset += 6 + 2*nNodes
 
-        if unpackHeader:
-            self.unpackHeader(serial)
+            # the last one may come later than the rest, if the ones between were coalesced
+            batch.iterations.append(Iteration(
+                firstIteration + k if k < count - 1 else lastIteration,
+                tau,
+                duration,
+                [t / TEMPERATURE_SCALE for t in temperatures]
+            ))
 
-        data = serial.read(self.length)
+        return batch
 
-        tau, iteration, nIterations, nNodes, nodeSize = struct.unpack('fhHHH', data)
-        self.tau = tau
-        self.iteration = iteration
-        self.nIterations = nIterations
-        self.nNodes = nNodes
-        self.nodeSize = nodeSize
+Frame = Union[MeshInfo, IterationBatch]
 
-        if self.nodeSize * self.nNodes == 0:
-            return
+class FrameReader:
+    """
+        Reads the frames from the serial port. Whatever does not form a frame with a valid CRC is
+        skipped, up to the next sync marker, and counted in `droppedBytes`.
+    """
 
-        data = serial.read(self.nodeSize * self.nNodes)
+    def __init__(self, serial: Serial):
+        self.serial = serial
+        self.buffer = bytearray()
+        self.droppedBytes = 0
 
-        for i in range(0, len(data), self.nodeSize):
-            node = ArduinoIterationPacket.Node()
-            node.unpack(data[i:i+self.nodeSize])
-            self.nodes.append(node)
+    def _fill(self, size: int) -> None:
+        while len(self.buffer) < size:
+            data = self.serial.read(size - len(self.buffer))
 
-def totalMicrosecons(diff: timedelta) -> int:
-    micros = diff.days * 24 * 60 * 60 * 1000000
-    micros += diff.seconds * 1000000
-    micros += diff.microseconds
+            if not data:
+                raise TimeoutError('No telemetry from the Arduino')
 
-    return micros
+            self.buffer += data
 
-@dataclass
-class ArduinoBenchmarkPacket(Packet):
-    arduinoMicrosStart: int = nan
-    arduinoMicrosEnd: int = nan
+    def _drop(self, size: int) -> None:
+        del self.buffer[:size]
+        self.droppedBytes += size
+
+    def read(self) -> Frame:
+        while True:
+            self._fill(len(SYNC))
+            start = self.buffer.find(SYNC)
+
+            if start < 0:
+                # the last byte may be the first one of a marker
+                self._drop(len(self.buffer) - 1)
+                continue
 
-    def unpackFromSerial(self, serial: Serial, unpackHeader = True):
-        if unpackHeader:
-            self.unpackHeader(serial)
+            self._drop(start)
+            self._fill(HEADER_SIZE)
 
-        microsStart, microsEnd = struct.unpack('LL', serial.read(self.length))
+            type, length = self.buffer[2], self.buffer[3]
+            self._fill(HEADER_SIZE + length + CRC_SIZE)
 
-        # if self.pcTimeStart and not self.pcTimeEnd:
-        #     self.pcTimeEnd = datetime.now()
+            payload = bytes(self.buffer[HEADER_SIZE:HEADER_SIZE + length])
+            crc, = struct.unpack_from('<H', self.buffer, HEADER_SIZE + length)
 
-        # if not self.pcTimeStart and not self.pcTimeEnd:
-        #     self.pcTimeStart = datetime.now()
+            if crc != crc16(self.buffer[2:HEADER_SIZE + length]) or type not in (FrameType.MeshInfo, FrameType.Iterations):
+                # not a frame, look for a marker after this one
+                self._drop(1)
+                continue
 
-        self.arduinoMicrosStart = microsStart
-        self.arduinoMicrosEnd = microsEnd
+            del self.buffer[:HEADER_SIZE + length + CRC_SIZE]
 
-    @property
-    def arduinoTimeElapsedMicros(self):
-        return self.arduinoMicrosEnd - self.arduinoMicrosStart
+            if type == FrameType.MeshInfo:
+                return MeshInfo.unpack(payload)
 
-packetMap = {
-    PacketType.IterationData: ArduinoIterationPacket,
-    PacketType.BenchmarkData: ArduinoBenchmarkPacket
-}
+            return IterationBatch.unpack(payload)
+
+def totalMicrosecons(diff: timedelta) -> int:
+    micros = diff.days * 24 * 60 * 60 * 1000000
+    micros += diff.seconds * 1000000
+    micros += diff.microseconds
+
+    return micros
@@ -4,14 +4,20 @@
 #include <LiquidCrystal_I2C.h>
 #include <print_util.h>
 #include <EEPROM.h>
-#include <Adafruit_MAX31855.h>
 
 #include "config.h"
 #include "lcd_util.h"
 #include "communication.h"
 #include "Menu.h"
 #include "Mesh.h"
+#include "AdaptiveStepper.h"
+#include "MaterialStepper.h"
+#include "ModalSolver.h"
 #include "BufferedLcd.h"
+#include "Scheduler.h"
+#include "TemperatureSampler.h"
+#include "RealTime.h"
+#include "Surrogate.h"
 
 using namespace lcdut;
 using namespace prnt;
@@ -19,6 +25,8 @@ using namespace prnt;
 namespace meshconfig {
     constexpr size_t nElements = MESH_SIZE;
     constexpr size_t nNodes = nElements + 1;
+    using Value = MESH_VALUE_TYPE;
+    constexpr int order = ELEMENT_ORDER;
 } // namespace meshconfig
 
 constexpr float minParamValue = 0.000001f;
@@ -30,7 +38,16 @@ struct Input {
         v1 - prędkość drugiej szpuli (>=v0) [m/s] - wprowadzanie ręczne
         r - promień wsadu [m] - wprowadzanie ręczne
         len - długość pieca [m] - zmienna kompilacji
-        n - ilośc kroków czasowych do wykonania
+        n - ilośc kroków czasowych do wykonania (przy adaptacyjnym kroku - początkowa)
+        meshGrading - rozkład węzłów (MeshGrading): 0 - równomierny, 1 - geometryczny, 2 - Czebyszewa
+        gradingRatio - stosunek rozmiaru elementu przy powierzchni do rozmiaru elementu w osi
+            (siatka geometryczna)
+        timeScheme - schemat całkowania w czasie (TimeScheme): 0 - Euler wstecz, 1 - Crank-Nicolson,
+            2 - Crank-Nicolson ze startem Rannachera, 3 - BDF2 (tylko przy stałym kroku)
+        tolerance - dopuszczalny błąd lokalny jednego kroku [deg C], przy własnościach zależnych od
+            temperatury - dopuszczalna różnica między temperaturami, przy których wzięto własności,
+            a obliczonymi
+        steadyRate - szybkość zmian temperatury, poniżej której cykl jest kończony [deg C/s]
 
         t_0 - temperatura początkowa wsadu [deg C] - wprowadzać ręcznie/z drugiego czujnika temp pokojowej
         t_furnance - temperatura w piecu [deg C] - z termopary
@@ -42,74 +59,141 @@ struct Input {
     float t0 = 20;                  // [deg C]
     unsigned nSteps = 20;
     unsigned integrationScheme = 1;
+    unsigned timeScheme = 0;
+    unsigned meshGrading = 0;
+    float gradingRatio = 0.3;
     float alphaAir = 300;   // [W/(m^2*K)]
     float C = 700.0;        // [J/(kg*K)]
     float Ro = 7800.0;      // [kg/m^3]
     float K = 25.0;         // [W/m*K]
+    float tolerance = 0.5;  // [deg C]
+    float steadyRate = 0.5; // [deg C/s]
 };
 
 Input input{};
+// the input the simulation runs with - in the real time mode made cheaper when it falls behind
+Input simulated{};
+// edited in the menu, and applied at the start of the next cycle
+Input edited{};
+bool inputEdited = false;
 
 namespace simulation {
     float tauEnd;
     float dTau;
+    // steps taken in the current cycle and the time after them
+    unsigned step;
+    float tau;
+    // time the cycle started [ms], the simulated time runs from it
+    unsigned long cycleStart;
+    // furnace temperature of the last step [deg C]
+    float ambient = NAN;
 } // namespace simulation
 
 BufferedLcd<LCD_COLS, LCD_ROWS> lcd{LCD_I2C_ADDR};
-Adafruit_MAX31855 thermocouple{TEMP_CLK_PIN, TEMP_CS_PIN, TEMP_DO_PIN};
 
-float getTemp() {
-    #if DEBUG_SERIAL_TEMP
-    if (Serial.available() < sizeof(float))
-        return NAN;
+#if DEBUG_SERIAL_TEMP
+// the PC sends the exact temperatures, one per cycle
+TemperatureSampler<TEMP_HISTORY_SIZE> sampler{TEMP_CLK_PIN, TEMP_CS_PIN, TEMP_DO_PIN, 1.f, false};
+bool newTemperature = false;
+#else
+TemperatureSampler<TEMP_HISTORY_SIZE> sampler{
+    TEMP_CLK_PIN, TEMP_CS_PIN, TEMP_DO_PIN, TEMP_FILTER_ALPHA, true
+};
 
-    float res;
-    Serial.readBytes((byte*) &res, sizeof(float));
+ISR(TIMER1_COMPA_vect) {
+    sampler.onTimer();
+}
+#endif
+
+Mesh<meshconfig::nNodes, meshconfig::Value, meshconfig::order> mesh{};
+
+#if TELEMETRY
+Telemetry<
+    meshconfig::nNodes, meshconfig::Value, TELEMETRY_BATCH, TELEMETRY_QUEUE_SIZE, TELEMETRY_COALESCE
+> telemetrySender{};
+#endif
+
+#if ADAPTIVE_TIME_STEP
+AdaptiveStepper<meshconfig::nNodes, meshconfig::Value, meshconfig::order> stepper{mesh};
+#elif TEMPERATURE_DEPENDENT_MATERIAL
+MaterialStepper<meshconfig::nNodes, meshconfig::Value> stepper{mesh};
+#elif MODAL_SOLVER
+ModalSolver<meshconfig::nNodes, meshconfig::Value, MODAL_MODES> stepper{mesh};
+#endif
+
+#if REAL_TIME
+RealTimePacer pacer{};
+
+// Makes the simulation cheaper, as far as the level of degradation of the pacer says
+void degrade(Input& params, const RealTimePacer& pacer) {
+    if (pacer.degraded(Degradation::CheaperScheme)) {
+        params.timeScheme = (unsigned) TimeScheme::BackwardEuler;
+        params.integrationScheme = 1;
+    }
 
-    return res;
+    #if ADAPTIVE_TIME_STEP
+    params.tolerance *= 1 << pacer.halvings();
     #else
-    DBG_Serial("Internal Temp = " << thermocouple.readInternal() << endl);
-
-    float c = thermocouple.readCelsius();
+    params.nSteps >>= pacer.halvings();
 
-    #if DEBUG_PRINTS
-    if (isnan(c)) {
-        Serial.println("Something wrong with thermocouple!");
-        Serial << "error: " << thermocouple.readError() << endl;
-    } else {
-        Serial << "C = " << c << endl;
-    }
+    if (params.nSteps == 0)
+        params.nSteps = 1;
     #endif
+}
+#endif
 
-    return c;
+// whether the steps are left out of the telemetry, to keep up with the wall clock
+bool stepTelemetrySkipped() {
+    #if REAL_TIME
+    return pacer.degraded(Degradation::NoTelemetry);
+    #else
+    return false;
     #endif
 }
 
-Mesh<meshconfig::nNodes> mesh{};
-IterationDataPacket<meshconfig::nNodes> iterData{mesh.nodes};
-
 void calculateSimulationParams() {
     using namespace simulation;
+
+    simulated = input;
+
+    #if REAL_TIME
+    degrade(simulated, pacer);
+    #endif
+
     // założenia:
     //    - liniowe przyspieszenie między v0 i v1
     //    - piec jest po środku między szpulami
     //    - prędkość nie zmienia się znacząco na długości pieca
-    float v = (input.v0 + input.v1)/2.f;
+    float v = (simulated.v0 + simulated.v1)/2.f;
 
-    tauEnd = input.furnaceLength / v;
+    tauEnd = simulated.furnaceLength / v;
 
     // float a = config.K / (config.C * config.Ro);
-    float elemSize = input.r / meshconfig::nElements;
 
     // dTau = (elemSize * elemSize) / (0.5 * a);
     // nSteps = (tauEnd / dTau) + 1;
-    dTau = tauEnd / input.nSteps;
+    dTau = tauEnd / simulated.nSteps;
+
+    step = 0;
+    tau = 0.f;
 
-    iterData.nSteps = input.nSteps;
-    iterData.step = 0;
-    iterData.tau = 0.f;
+    mesh.generate(simulated.t0, simulated.r, (MeshGrading) simulated.meshGrading, simulated.gradingRatio);
+    mesh.selectIntegrationScheme(simulated.integrationScheme);
 
-    mesh.generate(input.t0, elemSize);
+    #if ADAPTIVE_TIME_STEP
+    stepper.start(dTau, tauEnd, simulated.r, simulated.tolerance, simulated.steadyRate, simulated);
+    #elif TEMPERATURE_DEPENDENT_MATERIAL
+    stepper.start(dTau, simulated.r, simulated.tolerance, simulated);
+    #elif MODAL_SOLVER
+    stepper.decompose(simulated.r, simulated);
+    #else
+    mesh.selectTimeScheme((TimeScheme) simulated.timeScheme);
+    mesh.restartCycle();
+
+    #if CACHED_SYSTEM_MATRIX
+    mesh.assemble(dTau, simulated.r, simulated);
+    #endif
+    #endif
 }
 
 void updateEEPROM() {
@@ -121,17 +205,27 @@ void updateEEPROM() {
 
 MenuItem menuItems[] = {
     // max lcd.cols chars!
-    { "N krokow czas.",     &input.nSteps,            MenuItemType::_uint  },
-    { "t0 [C]",             &input.t0,                MenuItemType::_float },
-    { "Promien wsadu[m]",   &input.r,                 MenuItemType::_float },
-    { "v0 [m/s]",           &input.v0,                MenuItemType::_float },
-    { "v1 [m/s]",           &input.v1,                MenuItemType::_float },
-    { "Sch. calk. 1-4",     &input.integrationScheme, MenuItemType::_uint  },
-    { "\xE0 air [W/m^2*K]", &input.alphaAir,          MenuItemType::_float },
-    { "Cp. wl. [J/kgK]",    &input.C,                 MenuItemType::_float },
-    { "\xE6 [kg/m3]",       &input.Ro,                MenuItemType::_float },
-    { "K [W/m*K]",          &input.K,                 MenuItemType::_float },
-    { "Dlg. pieca [m]",     &input.furnaceLength,     MenuItemType::_float },
+    { "N krokow czas.",     &edited.nSteps,           MenuItemType::_uint  },
+    { "t0 [C]",             &edited.t0,               MenuItemType::_float },
+    { "Promien wsadu[m]",   &edited.r,                MenuItemType::_float },
+    { "v0 [m/s]",           &edited.v0,               MenuItemType::_float },
+    { "v1 [m/s]",           &edited.v1,               MenuItemType::_float },
+    { "Sch. calk. 1-4",     &edited.integrationScheme,MenuItemType::_uint  },
+    { "\xE0 air [W/m^2*K]", &edited.alphaAir,         MenuItemType::_float },
+    { "Cp. wl. [J/kgK]",    &edited.C,                MenuItemType::_float },
+    { "\xE6 [kg/m3]",       &edited.Ro,               MenuItemType::_float },
+    { "K [W/m*K]",          &edited.K,                MenuItemType::_float },
+    { "Dlg. pieca [m]",     &edited.furnaceLength,    MenuItemType::_float },
+    { "Siatka 0-2",         &edited.meshGrading,      MenuItemType::_uint  },
+    { "Wsp. zageszcz.",     &edited.gradingRatio,     MenuItemType::_float },
+    #if ADAPTIVE_TIME_STEP
+    { "Tolerancja [C]",     &edited.tolerance,        MenuItemType::_float },
+    { "Pr. ustal.[C/s]",    &edited.steadyRate,       MenuItemType::_float },
+    #elif TEMPERATURE_DEPENDENT_MATERIAL
+    { "Tolerancja [C]",     &edited.tolerance,        MenuItemType::_float },
+    #else
+    { "Sch. czasu 0-3",     &edited.timeScheme,       MenuItemType::_uint  },
+    #endif
 };
 
 // using MyMenu = Menu;
@@ -140,7 +234,282 @@ MyMenu menu{lcd, menuItems};
 
 bool isError = false;
 char stored[lcd.rows*lcd.cols];
-BenchmarkDataPacket benchmark;
+
+// Takes the new furnace temperature samples, and shows the thermocouple errors
+void sampleTemperature() {
+    #if DEBUG_SERIAL_TEMP
+    if (Serial.available() < sizeof(float))
+        return;
+
+    float t;
+    Serial.readBytes((byte*) &t, sizeof(float));
+    sampler.add(millis(), t);
+    newTemperature = true;
+    #else
+    sampler.update(millis());
+
+    DBG_Serial(
+        "C = " << sampler.latest() << ", internal = " << sampler.coldJunction()
+        << ", faults: " << sampler.faults() << endl
+    );
+
+    if (menu.active())
+        return;
+
+    if (!sampler.valid() && !isError) {
+        isError = true;
+        lcd.saveContents(stored);
+        lcd << pos(0,0) << "Thermocouple";
+        lcd << pos(0, 1) << "error nr " << sampler.faults();
+    }
+    else if (sampler.valid() && isError) {
+        isError = false;
+        lcd.restoreContents(stored);
+    }
+    #endif
+}
+
+// Whether a cycle can start - in DEBUG_SERIAL_TEMP mode each one waits for its own temperature
+bool temperatureReady() {
+    #if DEBUG_SERIAL_TEMP
+    if (!newTemperature)
+        return false;
+
+    newTemperature = false;
+    return true;
+    #else
+    return sampler.valid();
+    #endif
+}
+
+/*
+    Furnace temperature for the step ending at the simulated time `tau`. The cycle follows the
+    wire through the furnace, so the simulated time maps to the time since the cycle started.
+    When the simulation runs ahead of that, it is the newest sample.
+*/
+float ambientAt(float tau) {
+    return sampler.at(simulation::cycleStart + (unsigned long) (tau * 1000));
+}
+
+// whether the simulation may write to the LCD - not over the menu or an error
+bool lcdAvailable() {
+    return !menu.active() && !isError;
+}
+
+// Shows the core and surface temperatures at the end of a cycle, and the furnace temperature
+void showCycleResult(float core, float surface, float ambient) {
+    lcd << clear << pos(0, 0) << core;
+    lcd << pos(8, 0) << surface;
+    lcd << pos(0, 1) << ambient;
+}
+
+#if SURROGATE_TABLE
+// Finishes the cycle at once, with the end temperatures from the surrogate table
+void lookUpCycle() {
+    float temp = sampler.latest();
+    simulation::ambient = temp;
+
+    surrogate::Result result = surrogate::evaluate(
+        simulation::tauEnd, simulated.r, simulated.t0, temp
+    );
+
+    DBG_Serial("surrogate: core " << result.core << ", surface " << result.surface
+        << ", error < " << result.error << endl);
+
+    if (lcdAvailable())
+        showCycleResult(result.core, result.surface, temp);
+}
+#endif
+
+/*
+    Performs one integration step. A new cycle starts with the parameters edited in the menu
+    since the last one, and waits for a valid furnace temperature. In the real time mode the
+    step also waits until the wall clock reaches its end. With the surrogate table, the cycles it
+    covers end at once, without any steps.
+*/
+void integrationStep() {
+    if (simulation::step == 0) {
+        if (inputEdited) {
+            inputEdited = false;
+            input = edited;
+            calculateSimulationParams();
+            updateEEPROM();
+        }
+
+        if (!temperatureReady())
+            return;
+
+        simulation::cycleStart = millis();
+
+        #if SURROGATE_TABLE
+        if (surrogate::covers(simulated, simulation::tauEnd, meshconfig::nElements)) {
+            lookUpCycle();
+            return;
+        }
+        #endif
+
+        #if REAL_TIME
+        pacer.startCycle(micros());
+        #endif
+
+        #if TELEMETRY
+        telemetrySender.start(mesh.nodes, simulated.nSteps, simulation::tauEnd);
+        #endif
+    }
+
+    #if ADAPTIVE_TIME_STEP
+    // the step may still get shorter, but not longer
+    float stepEnd = min(stepper.time() + stepper.stepSize(), simulation::tauEnd);
+    #else
+    float stepEnd = simulation::tau + simulation::dTau;
+    #endif
+
+    #if REAL_TIME
+    if (!pacer.due(stepEnd, micros()))
+        return;
+    #endif
+
+    float temp = ambientAt(stepEnd);
+    simulation::ambient = temp;
+
+    #if REAL_TIME || TELEMETRY
+    unsigned long stepStart = micros();
+    #endif
+
+    #if ADAPTIVE_TIME_STEP || TEMPERATURE_DEPENDENT_MATERIAL
+    stepper.step(temp);
+    #elif MODAL_SOLVER
+    stepper.step(simulation::dTau, temp);
+    #elif CACHED_SYSTEM_MATRIX
+    mesh.integrateStep(temp);
+    #else
+    mesh.integrateStep(simulation::dTau, simulated.r, temp, simulated);
+    #endif
+
+    #if REAL_TIME || TELEMETRY
+    unsigned long stepStop = micros();
+    #endif
+
+    #if REAL_TIME
+    float tauBefore = simulation::tau;
+    #endif
+
+    simulation::step++;
+
+    #if ADAPTIVE_TIME_STEP
+    simulation::tau = stepper.time();
+    bool cycleFinished = stepper.finished();
+    #else
+    simulation::tau += simulation::dTau;
+    // dTau = tauEnd / nSteps, so the last step ends at tauEnd
+    bool cycleFinished = simulation::step >= simulated.nSteps;
+    #endif
+
+    #if REAL_TIME
+    pacer.stepDone(tauBefore, simulation::tau, stepStart, stepStop);
+    #endif
+
+    #if TELEMETRY
+    if (!stepTelemetrySkipped())
+        telemetrySender.record(simulation::step, simulation::tau, stepStop - stepStart, mesh.nodes);
+
+    if (cycleFinished)
+        telemetrySender.endCycle();
+    #endif
+
+    if (!cycleFinished) {
+        if (lcdAvailable()) {
+            lcd << pos(8, 1) << "    ";
+            lcd << pos(8, 1) << (int) (100 * simulation::tau/simulation::tauEnd) << '%';
+        }
+
+        return;
+    }
+
+    #if REAL_TIME
+    bool degradationChanged = pacer.endCycle(simulation::tau, stepStop);
+    #endif
+
+    if (lcdAvailable()) {
+        showCycleResult((float) mesh.nodes[0].t, (float) mesh.nodes[meshconfig::nNodes - 1].t, temp);
+
+        #if REAL_TIME
+        // how old the result is
+        lcd << pos(8, 1) << '+' << pacer.cycleLag() / 1000 << "ms";
+        #endif
+    }
+
+    simulation::step = 0;
+    simulation::tau = 0.f;
+
+    #if REAL_TIME
+    // the next cycle with a different number of steps or scheme
+    if (degradationChanged) {
+        calculateSimulationParams();
+        return;
+    }
+    #endif
+
+    mesh.fill(simulated.t0);
+
+    #if ADAPTIVE_TIME_STEP || TEMPERATURE_DEPENDENT_MATERIAL
+    stepper.restart();
+    #else
+    mesh.restartCycle();
+    #endif
+}
+
+void readButtons() {
+    menu.update();
+}
+
+// Sends the changes of the screen buffer - the menu flushes by itself
+void refreshLcd() {
+    if (!menu.active())
+        lcd.flush();
+}
+
+#if TELEMETRY
+void pumpTelemetry() {
+    telemetrySender.pump();
+}
+#endif
+
+#if DEBUG_PRINTS
+void reportLatency();
+#endif
+
+Task tasks[] = {
+    // name             function            period [ms] deadline [ms]
+    { "buttons",        readButtons,        5,          20 },
+    { "temperature",    sampleTemperature,  100,        50 },
+    { "step",           integrationStep,    0,          0  },
+    { "lcd",            refreshLcd,         200,        100 },
+    #if TELEMETRY
+    { "telemetry",      pumpTelemetry,      0,          20 },
+    #endif
+    #if DEBUG_PRINTS
+    { "report",         reportLatency,      10000,      0  },
+    #endif
+};
+
+Scheduler<ARRAYSIZE(tasks)> scheduler{tasks};
+
+#if DEBUG_PRINTS
+void reportLatency() {
+    scheduler.report(Serial);
+
+    #if REAL_TIME
+    Serial << "real time: degradation " << pacer.level() << ", deadline misses " << pacer.misses()
+        << ", worst lag " << pacer.worstLag() << " us" << endl;
+    #endif
+
+    #if TEMPERATURE_DEPENDENT_MATERIAL && !ADAPTIVE_TIME_STEP
+    Serial << "material: assemblies " << stepper.assemblies() << ", steps not converged "
+        << stepper.unconvergedSteps() << endl;
+    #endif
+}
+#endif
 
 void setup() {
     Serial.begin(SERIAL_BAUD);
@@ -151,8 +520,9 @@ void setup() {
     while (!Serial)
         ;
 
-    if (!thermocouple.begin())
-        Serial << "Thermocouple init error" << endl;
+    #if !DEBUG_SERIAL_TEMP
+    sampler.start(TEMP_SAMPLE_PERIOD);
+    #endif
 
     lcd << pos(3, 0) << (char) 0b10111100 << " Ready " << (char) 0b11000101;
     lcd.flush();
@@ -161,6 +531,8 @@ void setup() {
     if (EEPROM.read(EEPROM_INPUT_PARAMS_ADDR) == EEPROM_READ_INDICATOR_VAL)
         EEPROM.get(EEPROM_INPUT_PARAMS_ADDR + 1, input);
 
+    edited = input;
+
     calculateSimulationParams();
     DBG_Serial(
         "Params: " << endl
@@ -176,106 +548,69 @@ void setup() {
         DECREMENT_BUTTON_PIN
     );
     menu.onParamUpdate([](){
-        if (input.r == 0.f)
-            input.r = minParamValue;
+        if (edited.r == 0.f)
+            edited.r = minParamValue;
 
-        if (input.v0 == 0.f)
-            input.v0 = minParamValue;
+        if (edited.v0 == 0.f)
+            edited.v0 = minParamValue;
 
-        if (input.v1 == 0.f)
-            input.v1 = minParamValue;
+        if (edited.v1 == 0.f)
+            edited.v1 = minParamValue;
 
-        if (input.furnaceLength == 0.f)
-            input.furnaceLength = minParamValue;
+        if (edited.furnaceLength == 0.f)
+            edited.furnaceLength = minParamValue;
 
-        if (input.nSteps == 0)
-            input.nSteps = 1;
+        if (edited.tolerance == 0.f)
+            edited.tolerance = minParamValue;
 
-        if (input.integrationScheme < 1)
-            input.integrationScheme = 1;
+        if (edited.nSteps == 0)
+            edited.nSteps = 1;
 
-        if (input.integrationScheme > 4)
-            input.integrationScheme = 4;
+        if (edited.integrationScheme < 1)
+            edited.integrationScheme = 1;
 
-        if (input.r < 0.f)
-            input.r *= -1;
+        if (edited.integrationScheme > 4)
+            edited.integrationScheme = 4;
 
-        if (input.v0 < 0.f)
-            input.v0 *= -1;
+        if (edited.timeScheme > (unsigned) TimeScheme::BDF2)
+            edited.timeScheme = (unsigned) TimeScheme::BDF2;
 
-        if (input.v1 < 0.f)
-            input.v1 *= -1;
+        if (edited.meshGrading > (unsigned) MeshGrading::Chebyshev)
+            edited.meshGrading = (unsigned) MeshGrading::Chebyshev;
 
-        if (input.furnaceLength < 0.f)
-            input.furnaceLength *= -1;
+        if (edited.gradingRatio <= 0.f)
+            edited.gradingRatio = 1.f;
 
-        if (input.v0 > input.v1)
-            input.v1 = input.v0;
+        if (edited.r < 0.f)
+            edited.r *= -1;
 
-        DBG_Serial(nameof(input.nSteps) << " = " << input.nSteps << endl);
+        if (edited.v0 < 0.f)
+            edited.v0 *= -1;
 
-        calculateSimulationParams();
-        updateEEPROM();
-    });
-}
+        if (edited.v1 < 0.f)
+            edited.v1 *= -1;
 
-void loop() {
-    static float temp = getTemp();
+        if (edited.furnaceLength < 0.f)
+            edited.furnaceLength *= -1;
 
-    menu.update();
+        if (edited.tolerance < 0.f)
+            edited.tolerance *= -1;
 
-    if (isnan(temp)) {
-        #if !DEBUG_SERIAL_TEMP
-        if (!isError) {
-            isError = true;
-            lcd.saveContents(stored);
-            lcd << pos(0,0) << "Thermocouple";
-            lcd << pos(0, 1) << "error nr " << thermocouple.readError();
-            lcd.flush();
-        }
-        #endif
-        temp = getTemp();
-        delay(50);
-        return;
-    }
-
-    if (isError) {
-        isError = false;
-        lcd.restoreContents(stored);
-    }
-
-    #if TELEMETRY
-    iterData.send();
-
-    benchmark.start().send();
-    #endif
-
-    mesh.integrateStep(simulation::dTau, input.r, temp, input);
+        if (edited.steadyRate < 0.f)
+            edited.steadyRate *= -1;
 
-    #if TELEMETRY
-    benchmark.end().send().clear();
-    #endif
-
-    if (iterData.step < input.nSteps) {
-        iterData.step++;
-        iterData.tau += simulation::dTau;
-        lcd << pos(8, 1) << "    ";
-        lcd << pos(8, 1) << (int) (100 * iterData.tau/simulation::tauEnd) << '%';
-        lcd.flush();
-    }
-    else {
-        lcd << clear << pos(0, 0) << mesh.nodes[0].t;
-        lcd << pos(8, 0) << mesh.nodes[meshconfig::nNodes - 1].t;
-        lcd << pos(0, 1) << temp;
+        if (edited.v0 > edited.v1)
+            edited.v1 = edited.v0;
 
-        lcd.flush();
+        DBG_Serial(nameof(edited.nSteps) << " = " << edited.nSteps << endl);
 
-        iterData.step = 0;
-        iterData.tau = 0.f;
+        inputEdited = true;
+    });
 
-        for (auto& node : mesh.nodes)
-            node.t = input.t0;
+    scheduler.start();
+}
 
-        temp = getTemp();
-    }
+void loop() {
+    scheduler.runOnce();
+    watchdogTimer.reset();
 }
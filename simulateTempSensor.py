@@ -4,7 +4,7 @@ from typing import List, Optional
 from serial import Serial
 import os
 from os import path
-from communication import ArduinoBenchmarkPacket, ArduinoIterationPacket, Packet, totalMicrosecons
+from communication import FrameReader, Iteration, MeshInfo
 from heatingCurve import heatingCurve
 from util import getAndUpdateArduinoPort
 import time
@@ -50,6 +50,9 @@ time.sleep(8)
 serial.write(0)
 time.sleep(5)
 
+reader = FrameReader(serial)
+meshInfo: Optional[MeshInfo] = None
+
 plt.ion()
 figure, (oneCycleAx, allCyclesAx) = plt.subplots(nrows=2, ncols=1, figsize=(10, 8))
 
@@ -104,63 +107,53 @@ try:
 
             serial.write(struct.pack('f', t))
 
-            iterPacket: ArduinoIterationPacket = Packet.readFromSerial(serial)
-            print(f"tau = {iterPacket.tau:.4f}, iteration: {iterPacket.iteration}/{iterPacket.nIterations}", end='', flush=True)
-            # first packet - before integration step starts
-            benchmarkPacket: ArduinoBenchmarkPacket = Packet.readFromSerial(serial)
-            # second packet - after integration step
-            benchmarkPacket.unpackFromSerial(serial)
-            oneCycleData = np.array([[iterPacket.tau, iterPacket.nodes[0].t, iterPacket.nodes[-1].t]])
-
-            # write to file
-            if csv:
-                csv.writerow({
-                    'cycle': i,
-                    'iteration': iterPacket.iteration,
-                    'arduinoDurationMicros': benchmarkPacket.arduinoTimeElapsedMicros,
-                    'tempAmb': t,
-                    'tempIn': iterPacket.nodes[0].t,
-                    'tempOut': iterPacket.nodes[-1].t,
-                    'tau': iterPacket.tau
-                })
-
-            while iterPacket.iteration < iterPacket.nIterations:
-                iterPacket.unpackFromSerial(serial)
-
-                # check if the params were changed mid-cycle and the cycle is reset on Arduino side
-                if iterPacket.iteration == 0:
-                    break
+            oneCycleData = np.empty((0, 3))
+            last: Optional[Iteration] = None
+
+            while True:
+                frame = reader.read()
+
+                if isinstance(frame, MeshInfo):
+                    if meshInfo and (frame.droppedFrames, frame.coalescedIterations) != (meshInfo.droppedFrames, meshInfo.coalescedIterations):
+                        print(f"\nTelemetry lost on the Arduino: {frame.droppedFrames} frames dropped, {frame.coalescedIterations} iterations coalesced")
 
-                # first packet - before integration step starts
-                benchmarkPacket = Packet.readFromSerial(serial)
-                # second packet - after integration step
-                benchmarkPacket.unpackFromSerial(serial)
+                    meshInfo = frame
 
-                oneCycleData = np.append(oneCycleData, [[iterPacket.tau, iterPacket.nodes[0].t, iterPacket.nodes[-1].t]], axis=0)
+                    # check if the params were changed mid-cycle and the cycle is reset on Arduino side
+                    if last is not None:
+                        break
 
-                print(f"\rtau = {iterPacket.tau:.4f}, iteration: {iterPacket.iteration}/{iterPacket.nIterations}  ", end='', flush=True)
+                    continue
+
+                for iteration in frame.iterations:
+                    last = iteration
+                    oneCycleData = np.append(oneCycleData, [[iteration.tau, iteration.temperatures[0], iteration.temperatures[-1]]], axis=0)
 
-                if csv:
-                    csv.writerow({
-                        'cycle': i,
-                        'iteration': iterPacket.iteration,
-                        'arduinoDurationMicros': benchmarkPacket.arduinoTimeElapsedMicros,
-                        'tempAmb': t,
-                        'tempIn': iterPacket.nodes[0].t,
-                        'tempOut': iterPacket.nodes[-1].t,
-                        'tau': iterPacket.tau
-                    })
+                    print(f"\rtau = {iteration.tau:.4f}, iteration: {iteration.iteration}/{meshInfo.nIterations if meshInfo else '?'}  ", end='', flush=True)
 
+                    if csv:
+                        csv.writerow({
+                            'cycle': i,
+                            'iteration': iteration.iteration,
+                            'arduinoDurationMicros': iteration.arduinoDurationMicros,
+                            'tempAmb': t,
+                            'tempIn': iteration.temperatures[0],
+                            'tempOut': iteration.temperatures[-1],
+                            'tau': iteration.tau
+                        })
 
                 figure.canvas.flush_events()
 
+                if frame.cycleEnd:
+                    break
+
             print()
 
             # print(oneCycleData)
             updatePlotLines(oneCycleAx, oneCycleLines, oneCycleData)
 
-            oneCycleData = np.array([[0,0,0]])
-            allCyclesData = np.append(allCyclesData, [[tau, t, iterPacket.nodes[0].t, iterPacket.nodes[-1].t]], axis=0)
+            if last is not None:
+                allCyclesData = np.append(allCyclesData, [[tau, t, last.temperatures[0], last.temperatures[-1]]], axis=0)
 
             # print(allCyclesData)
             updatePlotLines(allCyclesAx, allCyclesLines, allCyclesData)